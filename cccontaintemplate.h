@@ -204,6 +204,54 @@ void PopContentFunc(void* p) {
     }
 }
 
+template<class T, class Container>
+void PushBulkContentFunc(void* p) {
+    CCContainUnit<T, Container>* pTest = (CCContainUnit<T, Container>*)p;
+    Container* pContainer = pTest->GetContainer();
+    T nodes[BULK_SIZE];
+    uint32_t nCount = 0;
+    while (true) {
+        T* pRet = pTest->GetPushCtx();
+        if (pRet == nullptr)
+            break;
+        nodes[nCount++] = *pRet;
+        if (nCount == BULK_SIZE) {
+            pContainer->PushBulk(nodes, nCount);
+            nCount = 0;
+        }
+    }
+    pContainer->PushBulk(nodes, nCount);
+}
+
+template<class T, class Container>
+void PushTokenContentFunc(void* p) {
+    CCContainUnit<T, Container>* pTest = (CCContainUnit<T, Container>*)p;
+    Container* pContainer = pTest->GetContainer();
+    typename Container::ProducerToken token(*pContainer);
+    while (true) {
+        T* pRet = pTest->GetPushCtx();
+        if (pRet == nullptr)
+            break;
+        token.Push(*pRet);
+    }
+    token.Flush();
+}
+
+template<class T, class Container>
+void PopBulkContentFunc(void* p) {
+    CCContainUnitThread<T, Container>* pTest = (CCContainUnitThread<T, Container>*)p;
+    Container* pContainer = pTest->GetContainer();
+    T nodes[BULK_SIZE];
+    while (true) {
+        uint32_t nCount = pContainer->PopBulk(nodes, BULK_SIZE);
+        if (nCount == 0)
+            break;
+        for (uint32_t i = 0; i < nCount; i++) {
+            pTest->Receive(&nodes[i]);
+        }
+    }
+}
+
 
 template<class T, class Container>
 void PushContentNoNullFunc(void* p) {
@@ -247,6 +295,28 @@ void PopContentNoNullFunc(void* p) {
     }
 }
 
+//park in WaitPopFor instead of sleep when empty
+template<class T, class Container>
+void PopContentWaitNoNullFunc(void* p) {
+    CCContainUnitThread<T, Container>* pTest = (CCContainUnitThread<T, Container>*)p;
+    Container* pContainer = pTest->GetContainer();
+    T node;
+    while (pTest->GetTimeStatus() != CCContainUnitStatus_Finish) {
+        if (!pContainer->WaitPopFor(node, 10)) {
+            pTest->NoPopData();
+            continue;
+        }
+        pTest->Receive(&node);
+    }
+    //pop all data
+    while (true) {
+        if (!pContainer->Pop(node)) {
+            break;
+        }
+        pTest->Receive(&node);
+    }
+}
+
 //use time
 #define PrintLockfreeUseTime(calcName, totalPerformance)\
 [&](DWORD dwUseTime, DWORD dwTotalUseTime){\
@@ -265,9 +335,11 @@ public:
         
     }
 
+    //! nReceiveThreadCount 0 use the same count as nThreadCount
     template<class F>
-    bool RepeatCCContainUnitThread(uint32_t nThreadCount, uint32_t maxPushTimes, F func) {
-        uint32_t nReceiveThreadCount = nThreadCount;
+    bool RepeatCCContainUnitThread(uint32_t nThreadCount, uint32_t maxPushTimes, F func, uint32_t nReceiveThreadCount = 0) {
+        if (nReceiveThreadCount == 0)
+            nReceiveThreadCount = nThreadCount;
         for (uint32_t i = 0; i < m_nRepeatTimes; i++) {
             auto p = createUnitThread();
             p->Init(m_pContain, nThreadCount, maxPushTimes);
@@ -280,7 +352,7 @@ public:
         return true;
     }
 
-    bool PowerOfTwoThreadCountImpl(uint32_t nThreadCount, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPush, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop) {
+    bool PowerOfTwoThreadCountImpl(uint32_t nThreadCount, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPush, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop, uint32_t nPopThreadCount = 0) {
         bool bRet = true;
         char szBuf[2][32];
         ccsnprintf(szBuf[0], 32, "ThreadCount(%d) Push", nThreadCount);
@@ -289,7 +361,7 @@ public:
         CreateCalcUseTime(beginrece, PrintLockfreeUseTime(szBuf[1], m_nMaxCountTimesFast / nThreadCount * m_nRepeatTimes * nThreadCount), false);
         RepeatCCContainUnitThread(nThreadCount, m_nMaxCountTimesFast / nThreadCount, [&](CCContainUnitThread<T, Container>* pMgr, uint32_t nReceiveThreadCount) {
             bool bFuncRet = true;
-            std::thread* pPushThread = new std::thread[nThreadCount];
+            std::thread* pPushThread = new std::thread[nThreadCount > nReceiveThreadCount ? nThreadCount : nReceiveThreadCount];
             StartCalcUseTime(begin);
             for (uint32_t j = 0; j < nThreadCount; j++) {
                 pPushThread[j] = std::thread(lpStartAddressPush, pMgr->GetContainUintByIndex(j));
@@ -312,15 +384,16 @@ public:
             }
             delete[]pPushThread;
             return bFuncRet;
-        });
+        }, nPopThreadCount);
         CallbackUseTime(begin);
         CallbackUseTime(beginrece);
         return bRet;
     }
 
-    bool PowerOfTwoThreadCountTest(CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPush, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop, uint32_t nMaxThreadCount = 8, uint32_t nMinThreadCount = 1) {
+    //! nPopThreadCount 0 pop with the same thread count as push, 1 for the single consumer container
+    bool PowerOfTwoThreadCountTest(CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPush, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop, uint32_t nMaxThreadCount = 8, uint32_t nMinThreadCount = 1, uint32_t nPopThreadCount = 0) {
         for (uint32_t nThreadCount = nMinThreadCount; nThreadCount <= nMaxThreadCount; nThreadCount *= 2) {
-            if (!PowerOfTwoThreadCountImpl(nThreadCount, lpStartAddressPush, lpStartAddressPop))
+            if (!PowerOfTwoThreadCountImpl(nThreadCount, lpStartAddressPush, lpStartAddressPop, nPopThreadCount))
                 return false;
         }
         return true;
@@ -357,7 +430,7 @@ public:
         
     }
 
-    bool PowerOfTwoThreadCountImpl(uint32_t nPushThreadCount, uint32_t nPopThreadCount) {
+    bool PowerOfTwoThreadCountImpl(uint32_t nPushThreadCount, uint32_t nPopThreadCount, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop) {
         bool bRet = true;
         char szBuf[128];
         ccsnprintf(szBuf, 128, "PushThreadCount(%d) PopThreadCount(%d)", nPushThreadCount, nPopThreadCount);
@@ -376,7 +449,7 @@ public:
             pPushThread[j] = std::thread(PushContentNoNullFunc<T, Container>, pMgr->GetContainUintByIndex(j));
         }
         for (uint32_t j = 0; j < nPopThreadCount; j++) {
-            pPopThread[j] = std::thread(PopContentNoNullFunc<T, Container>, pMgr);
+            pPopThread[j] = std::thread(lpStartAddressPop, pMgr);
         }
         while (!IsTimeEnoughUseTime(begin, m_nTotalTimes, PrintEffect(szBuf, pMgr))) {
             if (!IsTimeEnoughUseTime(begin, nCheckTime, PrintEffect(szBuf, pMgr))) {
@@ -384,6 +457,7 @@ public:
                 continue;
             }
             nCheckTime += PRINT_TIME;
+            //throttle for the unbounded container, the bounded one wait in Push by itself
             if (pMgr->GetContainSize() > 1024 * 1024 * 10) {
                 pMgr->SetTimeWait();
             }
@@ -409,8 +483,8 @@ public:
         return bRet;
     }
 
-    bool PowerOfTwoThreadCountTest(uint32_t nPushThreadCount, uint32_t nPopThreadCount) {
-        return PowerOfTwoThreadCountImpl(nPushThreadCount, nPopThreadCount);
+    bool PowerOfTwoThreadCountTest(uint32_t nPushThreadCount, uint32_t nPopThreadCount, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop = PopContentNoNullFunc<T, Container>) {
+        return PowerOfTwoThreadCountImpl(nPushThreadCount, nPopThreadCount, lpStartAddressPop);
     }
 
 protected:
@@ -5,42 +5,133 @@
 #include <atomic>
 #include <assert.h>
 #include <cstring>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_map>
 
 #ifdef _MSC_VER
 #include <windows.h>
 #define CCSwitchToThread() SwitchToThread();
 #else
 #include <emmintrin.h>
-#include <thread>
+#include <sys/mman.h>
 #define CCSwitchToThread() std::this_thread::yield();
 #endif
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+//! SIMD scan of the flag array, AVX2 need -mavx2 or /arch:AVX2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CCLOCKFREE_USE_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CCLOCKFREE_USE_SSE2
+#endif
 
 #ifdef __GNUC__
 #if defined(__APPLE__)
 #include <libkern/OsAtomic.h>
-#define CCLockfreeInterlockedIncrement(value) (OSAtomicAdd32(1, (volatile int32_t *)value) - 1)
-#define CCLockfreeInterlockedDecrementNoCheckReturn(value) OSAtomicAdd32(-1, (volatile int32_t *)value)
-#define CCLockfreeInterlockedDecrement(value)  (OSAtomicAdd32(-1, (volatile int32_t *)value) + 1)
-#define CCLockfreeInterlockedCompareExchange(value, comp, exchange) OSAtomicCompareAndSwap32(comp, exchange, (volatile int32_t *)value)
+namespace cclockfree {
+    //! the uint64_t IndexType take the 64 bits op, return the value before add
+    template<class T>
+    inline T CCLockfreeInterlockedAddSize(volatile T* value, T add, std::false_type) {
+        return (T)(OSAtomicAdd32((int32_t)add, (volatile int32_t *)value) - (int32_t)add);
+    }
+    template<class T>
+    inline T CCLockfreeInterlockedAddSize(volatile T* value, T add, std::true_type) {
+        return (T)(OSAtomicAdd64((int64_t)add, (volatile int64_t *)value) - (int64_t)add);
+    }
+    template<class T>
+    inline bool CCLockfreeInterlockedCompareExchangeSize(volatile T* value, T comp, T exchange, std::false_type) {
+        return OSAtomicCompareAndSwap32((int32_t)comp, (int32_t)exchange, (volatile int32_t *)value);
+    }
+    template<class T>
+    inline bool CCLockfreeInterlockedCompareExchangeSize(volatile T* value, T comp, T exchange, std::true_type) {
+        return OSAtomicCompareAndSwap64((int64_t)comp, (int64_t)exchange, (volatile int64_t *)value);
+    }
+}
+#define CCLockfreeInterlockedCompareExchangePointer(value, comp, exchange) OSAtomicCompareAndSwapPtr(comp, exchange, (void* volatile *)value)
 #else
 #define CCLockfreeInterlockedIncrement(value) __sync_fetch_and_add(value, 1)
+#define CCLockfreeInterlockedAdd(value, add) __sync_fetch_and_add(value, add)
 #define CCLockfreeInterlockedDecrementNoCheckReturn(value) __sync_fetch_and_sub(value, 1)
 #define CCLockfreeInterlockedDecrement(value) CCLockfreeInterlockedDecrementNoCheckReturn(value)
 #define CCLockfreeInterlockedCompareExchange(value, comp, exchange) __sync_bool_compare_and_swap(value, comp, exchange)
+#define CCLockfreeInterlockedCompareExchangePointer(value, comp, exchange) __sync_bool_compare_and_swap(value, comp, exchange)
 #endif
 
 #define CCLockfreequeueLikely(x) __builtin_expect((x), true)
 #define CCLockfreequeueUnLikely(x) __builtin_expect((x), false)
 #elif defined(_MSC_VER)
-#define CCLockfreeInterlockedIncrement(value) (::InterlockedIncrement(value) - 1)
-#define CCLockfreeInterlockedDecrementNoCheckReturn(value) ::InterlockedDecrement(value)
-#define CCLockfreeInterlockedDecrement(value) (::InterlockedDecrement(value) + 1)
-#define CCLockfreeInterlockedCompareExchange(value, comp, exchange) (::InterlockedCompareExchange(value, exchange, comp) == comp)
+namespace cclockfree {
+    //! the uint64_t IndexType take the 64 bits op, return the value before add
+    template<class T>
+    inline T CCLockfreeInterlockedAddSize(volatile T* value, T add, std::false_type) {
+        return (T)::InterlockedExchangeAdd((volatile LONG*)value, (LONG)add);
+    }
+    template<class T>
+    inline T CCLockfreeInterlockedAddSize(volatile T* value, T add, std::true_type) {
+        return (T)::InterlockedExchangeAdd64((volatile LONGLONG*)value, (LONGLONG)add);
+    }
+    template<class T>
+    inline bool CCLockfreeInterlockedCompareExchangeSize(volatile T* value, T comp, T exchange, std::false_type) {
+        return ::InterlockedCompareExchange((volatile LONG*)value, (LONG)exchange, (LONG)comp) == (LONG)comp;
+    }
+    template<class T>
+    inline bool CCLockfreeInterlockedCompareExchangeSize(volatile T* value, T comp, T exchange, std::true_type) {
+        return ::InterlockedCompareExchange64((volatile LONGLONG*)value, (LONGLONG)exchange, (LONGLONG)comp) == (LONGLONG)comp;
+    }
+}
+#define CCLockfreeInterlockedCompareExchangePointer(value, comp, exchange) (::InterlockedCompareExchangePointer((PVOID volatile *)value, exchange, comp) == (PVOID)(comp))
 
 #define CCLockfreequeueLikely(x) x
 #define CCLockfreequeueUnLikely(x) x
 #endif
 
+#if defined(__APPLE__) || defined(_MSC_VER)
+namespace cclockfree {
+    template<class T, class A>
+    inline T CCLockfreeInterlockedAddT(volatile T* value, A add) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "interlocked op only for 4 or 8 bytes error!");
+        return CCLockfreeInterlockedAddSize(value, (T)add, std::integral_constant<bool, sizeof(T) == 8>());
+    }
+    template<class T, class C, class E>
+    inline bool CCLockfreeInterlockedCompareExchangeT(volatile T* value, C comp, E exchange) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "interlocked op only for 4 or 8 bytes error!");
+        return CCLockfreeInterlockedCompareExchangeSize(value, (T)comp, (T)exchange, std::integral_constant<bool, sizeof(T) == 8>());
+    }
+}
+#define CCLockfreeInterlockedIncrement(value) cclockfree::CCLockfreeInterlockedAddT(value, 1)
+#define CCLockfreeInterlockedAdd(value, add) cclockfree::CCLockfreeInterlockedAddT(value, add)
+#define CCLockfreeInterlockedDecrementNoCheckReturn(value) cclockfree::CCLockfreeInterlockedAddT(value, -1)
+#define CCLockfreeInterlockedDecrement(value) cclockfree::CCLockfreeInterlockedAddT(value, -1)
+#define CCLockfreeInterlockedCompareExchange(value, comp, exchange) cclockfree::CCLockfreeInterlockedCompareExchangeT(value, comp, exchange)
+#endif
+
+//! CCLockfreePackSlot shift T in the uint64_t, it is only right on little endian
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#define CCLOCKFREE_LITTLE_ENDIAN (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#elif defined(_MSC_VER)
+#define CCLOCKFREE_LITTLE_ENDIAN 1
+#else
+#define CCLOCKFREE_LITTLE_ENDIAN 0
+#endif
+
+//! align the hot member by Traits::HotDataAlignSize, 0 means keep the natural align of type
+#define CCLockfreeAlignAs(Traits, type) alignas((Traits::HotDataAlignSize > alignof(type)) ? Traits::HotDataAlignSize : alignof(type))
+
 // Compiler-specific likely/unlikely hints
 namespace cclockfree {
     class atomic_backoff {
@@ -95,6 +186,50 @@ namespace cclockfree {
             count = 1;
         }
     };
+    //! index of the lowest set bit, nValue must not be 0
+    inline uint32_t CCLockfreeBitScanForward(uint32_t nValue) {
+#ifdef _MSC_VER
+        unsigned long nIndex;
+        _BitScanForward(&nIndex, nValue);
+        return nIndex;
+#else
+        return __builtin_ctz(nValue);
+#endif
+    }
+    //! return the first offset in [0, nCount) which (flag & nMask) != nValue, nCount when all equal
+    //! the flag is load relaxed, fence acquire before touch the data it guard
+    inline uint32_t CCLockfreeFindFlagNotEqual(const std::atomic<uint8_t>* pFlag, uint32_t nCount, uint8_t nValue, uint8_t nMask = 0xFF) {
+        static_assert(sizeof(std::atomic<uint8_t>) == 1, "std::atomic<uint8_t> is not one byte, can not scan by SIMD");
+        //the caller spin on it, do not let the compiler keep the vector load out of the loop
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        const uint8_t* pByte = reinterpret_cast<const uint8_t*>(pFlag);
+        uint32_t i = 0;
+#ifdef CCLOCKFREE_USE_AVX2
+        const __m256i vValue256 = _mm256_set1_epi8((char)nValue);
+        const __m256i vMask256 = _mm256_set1_epi8((char)nMask);
+        for (; i + 32 <= nCount; i += 32) {
+            __m256i vFlag = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(pByte + i)), vMask256);
+            uint32_t nNotEqual = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(vFlag, vValue256));
+            if (nNotEqual)
+                return i + CCLockfreeBitScanForward(nNotEqual);
+        }
+#endif
+#ifdef CCLOCKFREE_USE_SSE2
+        const __m128i vValue = _mm_set1_epi8((char)nValue);
+        const __m128i vMask = _mm_set1_epi8((char)nMask);
+        for (; i + 16 <= nCount; i += 16) {
+            __m128i vFlag = _mm_and_si128(_mm_loadu_si128((const __m128i*)(pByte + i)), vMask);
+            uint32_t nNotEqual = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(vFlag, vValue)) ^ 0xFFFF;
+            if (nNotEqual)
+                return i + CCLockfreeBitScanForward(nNotEqual);
+        }
+#endif
+        for (; i < nCount; i++) {
+            if ((pFlag[i].load(std::memory_order_relaxed) & nMask) != nValue)
+                return i;
+        }
+        return nCount;
+    }
     struct CCLockfreeFunc {
 #if defined(malloc) || defined(free)
         static inline void* malloc(size_t size) { return ::malloc(size); }
@@ -109,6 +244,358 @@ namespace cclockfree {
             printf(pData, std::forward<_Types>(_Args)...);
 #endif
         }
+
+        //! 0 pack the member, set to cache line size to put producer and consumer data on different cache line
+        static const size_t HotDataAlignSize = 0;
+
+        //! WaitPop try times before park the thread
+        static const uint32_t WaitSpinCount = 64;
+
+        //! CCLockfreeFixQueue slot layout, false put the flag after every T, true put all the T then all the flag
+        //! CCLockfreeQueue circle always use the split layout
+        static const bool SplitSlotLayout = false;
+        //! true trivially copyable T not more than 7 bytes share one uint64_t with the flag, push and pop by one atomic op
+        //! off by default, the small payload benchmark show no clear win over the flag slot yet
+        static const bool PackSmallSlot = false;
+        //! pointer T, the slot is the pointer itself and a small value mark it empty, push return false for nullptr
+        //! false keep the flag slot and any pointer can push
+        static const bool PointerSlot = false;
+        //! CCLockfreeFixQueue engine, false count space and readable by interlocked counter(4 atomic op every push/pop)
+        //! true every slot have a sequence, push and pop cas own cursor once, the slot is always the flag layout
+        static const bool SequenceSlot = false;
+        //! CCLockfreeFixQueue lossy ring, push overwrite the oldest unread slot when full and never fail for space
+        //! T must be trivially copyable, GetDropCount return the slot overwritten before pop
+        static const bool OverwriteOldest = false;
+        //! CCLockfreeFixQueue with defaultfixsize 0 alloc the slot on the heap by this align, default page
+        static const size_t FixQueueBufferAlignSize = 4096;
+        //! malloc return zero filled memory(calloc, mmap), the new pool skip the flag reset
+        static const bool MallocZeroMemory = false;
+    };
+    struct CCLockfreePaddingFunc : CCLockfreeFunc {
+        static const size_t HotDataAlignSize = 64;
+    };
+    struct CCLockfreeSplitFunc : CCLockfreeFunc {
+        static const bool SplitSlotLayout = true;
+    };
+    struct CCLockfreePackFunc : CCLockfreeFunc {
+        static const bool PackSmallSlot = true;
+    };
+    struct CCLockfreePointerFunc : CCLockfreeFunc {
+        static const bool PointerSlot = true;
+    };
+    struct CCLockfreeSequenceFunc : CCLockfreeFunc {
+        static const bool SequenceSlot = true;
+    };
+    struct CCLockfreeOverwriteFunc : CCLockfreeFunc {
+        static const bool OverwriteOldest = true;
+    };
+
+    //! the slot of T is one uint64_t, the low byte is the flag and T is in the high 7 bytes
+    //! little endian only, the big endian target keep the flag slot
+    template<class T, class Traits>
+    struct CCLockfreePackSlot {
+        static const bool value = Traits::PackSmallSlot && CCLOCKFREE_LITTLE_ENDIAN && !std::is_pointer<T>::value && sizeof(T) <= 7 && std::is_trivially_copyable<T>::value;
+
+        //! little endian, T is copy to the low bytes of the uint64_t so the shift keep all of it
+        static inline uint64_t Pack(const T& data, uint8_t nFlag) {
+            uint64_t nSlot = 0;
+            memcpy(&nSlot, (const void*)&data, sizeof(T));
+            return (nSlot << 8) | nFlag;
+        }
+        static inline void Unpack(uint64_t nSlot, T& data) {
+            nSlot >>= 8;
+            memcpy((void*)&data, &nSlot, sizeof(T));
+        }
+    };
+
+    //! numa helper, the machine without numa(or not linux/windows) is one node and the bind do nothing
+    //! call func for every number of the kernel list "0-3,8,10-11", false when the file can not read
+    template<class F>
+    inline bool CCLockfreeReadNumberList(const char* pPath, F&& func) {
+        FILE* pFile = fopen(pPath, "r");
+        if (pFile == nullptr)
+            return false;
+        char szBuf[1024];
+        bool bRet = fgets(szBuf, sizeof(szBuf), pFile) != nullptr;
+        fclose(pFile);
+        for (char* p = szBuf; bRet && *p >= '0' && *p <= '9';) {
+            uint32_t nBegin = (uint32_t)strtoul(p, &p, 10);
+            uint32_t nEnd = nBegin;
+            if (*p == '-')
+                nEnd = (uint32_t)strtoul(p + 1, &p, 10);
+            for (uint32_t i = nBegin; i <= nEnd; i++)
+                func(i);
+            if (*p == ',')
+                p++;
+        }
+        return bRet;
+    }
+    inline uint32_t CCLockfreeNumaNodeCount() {
+        uint32_t nCount = 1;
+#ifdef __linux__
+        CCLockfreeReadNumberList("/sys/devices/system/node/online", [&nCount](uint32_t nNode) {
+            if (nNode + 1 > nCount)
+                nCount = nNode + 1;
+        });
+#elif defined(_MSC_VER)
+        ULONG nHighestNode = 0;
+        if (GetNumaHighestNodeNumber(&nHighestNode))
+            nCount = nHighestNode + 1;
+#endif
+        return nCount;
+    }
+    //! run the calling thread only on the cpu of nNode, then the first touch of the thread alloc on the node
+    inline bool CCLockfreeNumaRunOnNode(uint32_t nNode) {
+#ifdef __linux__
+        char szPath[128];
+        snprintf(szPath, sizeof(szPath), "/sys/devices/system/node/node%u/cpulist", nNode);
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        bool bHasCpu = false;
+        CCLockfreeReadNumberList(szPath, [&](uint32_t nCpu) {
+            if (nCpu < CPU_SETSIZE) {
+                CPU_SET(nCpu, &cpuSet);
+                bHasCpu = true;
+            }
+        });
+        return bHasCpu && sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#elif defined(_MSC_VER)
+        ULONGLONG nMask = 0;
+        if (!GetNumaNodeProcessorMask((UCHAR)nNode, &nMask) || nMask == 0)
+            return false;
+        return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)nMask) != 0;
+#else
+        return nNode == 0;
+#endif
+    }
+    //! the node of the cpu the calling thread run on, 0 when unknown
+    //! it is read once and keep for the thread, pin the thread(CCLockfreeNumaRunOnNode) before the first call
+    inline uint32_t CCLockfreeNumaCurrentNode() {
+        static thread_local int32_t nThreadNode = -1;
+        if (nThreadNode >= 0)
+            return (uint32_t)nThreadNode;
+        nThreadNode = 0;
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned int nCpu = 0;
+        unsigned int nNode = 0;
+        if (syscall(SYS_getcpu, &nCpu, &nNode, nullptr) == 0)
+            nThreadNode = (int32_t)nNode;
+#elif defined(_MSC_VER)
+        PROCESSOR_NUMBER processor;
+        USHORT nNode = 0;
+        GetCurrentProcessorNumberEx(&processor);
+        if (GetNumaProcessorNodeEx(&processor, &nNode))
+            nThreadNode = nNode;
+#endif
+        return (uint32_t)nThreadNode;
+    }
+    //! the page of [p, p + nSize) not touch yet alloc on nNode, p is page align
+    inline bool CCLockfreeNumaBindMemory(void* p, size_t nSize, uint32_t nNode) {
+#if defined(__linux__) && defined(SYS_mbind)
+        //MPOL_BIND of linux/mempolicy.h
+        const int nBindMode = 2;
+        unsigned long nNodeMask[4] = { 0 };
+        const unsigned long nMaskBits = sizeof(nNodeMask) * 8;
+        if (nNode >= nMaskBits)
+            return false;
+        nNodeMask[nNode / (sizeof(unsigned long) * 8)] |= 1UL << (nNode % (sizeof(unsigned long) * 8));
+        return syscall(SYS_mbind, p, nSize, nBindMode, nNodeMask, nMaskBits + 1, 0) == 0;
+#else
+        (void)p;
+        (void)nSize;
+        return nNode == 0;
+#endif
+    }
+
+    //! the size of every block map by CCLockfreePageAlloc, keep out of the block so the block is page align
+    //! never destroy, a static queue may free its pool after the other static object
+    class CCLockfreePageMapTable {
+    public:
+        static CCLockfreePageMapTable& GetInstance() {
+            static CCLockfreePageMapTable* pInstance = new CCLockfreePageMapTable();
+            return *pInstance;
+        }
+        void Add(void* p, size_t nMapSize) {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_map[p] = nMapSize;
+        }
+        //! return 0 when p is not a map block
+        size_t Remove(void* p) {
+            std::lock_guard<std::mutex> lock(m_lock);
+            auto itr = m_map.find(p);
+            if (itr == m_map.end())
+                return 0;
+            size_t nMapSize = itr->second;
+            m_map.erase(itr);
+            return nMapSize;
+        }
+    protected:
+        std::mutex                          m_lock;
+        std::unordered_map<void*, size_t>   m_map;
+    };
+
+    //! page allocation policy for the Traits malloc/free, the big block is map from the system and the page is zero
+    //! bHugePage try MAP_HUGETLB first, then madvise(MADV_HUGEPAGE) on a HugePageSize align map(transparent huge page)
+    //! the block less than MinMapSize is calloc, the size of the map block is in CCLockfreePageMapTable
+    //! nNumaNode not less than 0 bind the map block to the node, the small block follow the first touch
+    template<bool bHugePage = false, int nNumaNode = -1>
+    struct CCLockfreePageAlloc {
+        static const size_t MinMapSize = 64 * 1024;
+        static const size_t PageSize = 4096;
+        static const size_t HugePageSize = 2 * 1024 * 1024;
+
+        static void* malloc(size_t nSize) {
+            if (nSize < MinMapSize)
+                return std::calloc(1, nSize);
+            size_t nMapSize = 0;
+            void* pRet = MapPage(nSize, nMapSize);
+            if (pRet)
+                CCLockfreePageMapTable::GetInstance().Add(pRet, nMapSize);
+            return pRet;
+        }
+        static void free(void* p) {
+            if (p == nullptr)
+                return;
+            //the map block is page align, the calloc block only look up the table when it is by chance
+            size_t nMapSize = ((uintptr_t)p & (PageSize - 1)) == 0 ? CCLockfreePageMapTable::GetInstance().Remove(p) : 0;
+            if (nMapSize == 0)
+                std::free(p);
+            else
+                UnmapPage(p, nMapSize);
+        }
+    protected:
+        static void* MapPage(size_t nSize, size_t& nMapSize) {
+#ifdef _MSC_VER
+            nMapSize = nSize;
+            if (nNumaNode >= 0)
+                return VirtualAllocExNuma(GetCurrentProcess(), nullptr, nSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE, (DWORD)nNumaNode);
+            return VirtualAlloc(nullptr, nSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+            void* pRet = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            if (bHugePage) {
+                //fail when the system has no reserve huge page
+                nMapSize = (nSize + HugePageSize - 1) & ~(HugePageSize - 1);
+                pRet = mmap(nullptr, nMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            }
+#endif
+            if (pRet == MAP_FAILED) {
+                nMapSize = (nSize + PageSize - 1) & ~(PageSize - 1);
+                //map one more huge page and cut the head and the tail to align it
+                size_t nAlignSize = bHugePage ? HugePageSize : 0;
+                char* pMap = (char*)mmap(nullptr, nMapSize + nAlignSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (pMap == (char*)MAP_FAILED)
+                    return nullptr;
+                pRet = pMap;
+                if (nAlignSize) {
+                    pRet = (void*)(((uintptr_t)pMap + nAlignSize - 1) & ~(uintptr_t)(nAlignSize - 1));
+                    size_t nHead = (char*)pRet - pMap;
+                    if (nHead)
+                        munmap(pMap, nHead);
+                    if (nAlignSize - nHead)
+                        munmap((char*)pRet + nMapSize, nAlignSize - nHead);
+                }
+#ifdef MADV_HUGEPAGE
+                if (bHugePage)
+                    madvise(pRet, nMapSize, MADV_HUGEPAGE);
+#endif
+            }
+            //the single node machine or the kernel without numa keep the default policy
+            if (nNumaNode >= 0)
+                CCLockfreeNumaBindMemory(pRet, nMapSize, (uint32_t)nNumaNode);
+            return pRet;
+#endif
+        }
+        static void UnmapPage(void* p, size_t nMapSize) {
+#ifdef _MSC_VER
+            (void)nMapSize;
+            VirtualFree(p, 0, MEM_RELEASE);
+#else
+            munmap(p, nMapSize);
+#endif
+        }
+    };
+
+    //! alloc by Traits::malloc and align the return pointer(nAlign power(2)), release by CCLockfreeAlignedFree
+    template<class Traits>
+    inline void* CCLockfreeAlignedMalloc(size_t nSize, size_t nAlign) {
+        if (nAlign < sizeof(void*))
+            nAlign = sizeof(void*);
+        char* pRaw = (char*)Traits::malloc(nSize + nAlign);
+        if (pRaw == nullptr)
+            return nullptr;
+        void** pRet = (void**)(((uintptr_t)pRaw + nAlign) & ~(uintptr_t)(nAlign - 1));
+        pRet[-1] = pRaw;
+        return pRet;
+    }
+    template<class Traits>
+    inline void CCLockfreeAlignedFree(void* p) {
+        if (p)
+            Traits::free(((void**)p)[-1]);
+    }
+
+    //! eventcount, consumer park when nothing to pop, producer only lock and wake when someone is waiting
+    class CCLockfreeEventCount {
+    public:
+        static const uint32_t Infinite = 0xFFFFFFFF;
+    public:
+        CCLockfreeEventCount() : m_nWaiters(0), m_nEpoch(0) {
+        }
+        //! must call after a full barrier which publish the data(the interlocked reserve of push)
+        inline void NotifyAfterBarrier(bool bAll = false) {
+            if (CCLockfreequeueUnLikely(m_nWaiters.load(std::memory_order_relaxed) != 0))
+                Notify(bAll);
+        }
+        void Notify(bool bAll) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_nEpoch.store(m_nEpoch.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            if (bAll)
+                m_cond.notify_all();
+            else
+                m_cond.notify_one();
+        }
+        //! func is the try pop, spin nSpinCount times then park, return false when timeout
+        template<class F>
+        bool WaitFor(F&& func, uint32_t nSpinCount, uint32_t nMilliseconds) {
+            atomic_backoff bPause;
+            for (uint32_t i = 0; i < nSpinCount; i++) {
+                if (func())
+                    return true;
+                bPause.pause();
+            }
+            std::chrono::steady_clock::time_point tmEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(nMilliseconds);
+            while (true) {
+                //register then check again, the producer see the waiter or we see the data
+                m_nWaiters.fetch_add(1);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                uint32_t nKey = m_nEpoch.load(std::memory_order_relaxed);
+                if (func()) {
+                    m_nWaiters.fetch_sub(1);
+                    return true;
+                }
+                bool bTimeout = false;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    while (m_nEpoch.load(std::memory_order_relaxed) == nKey) {
+                        if (nMilliseconds == Infinite) {
+                            m_cond.wait(lock);
+                        }
+                        else if (m_cond.wait_until(lock, tmEnd) == std::cv_status::timeout) {
+                            bTimeout = true;
+                            break;
+                        }
+                    }
+                }
+                m_nWaiters.fetch_sub(1);
+                if (bTimeout)
+                    return func();
+            }
+        }
+    protected:
+        std::atomic<uint32_t>       m_nWaiters;
+        std::atomic<uint32_t>       m_nEpoch;
+        std::mutex                  m_mutex;
+        std::condition_variable     m_cond;
     };
 
     template<class Traits = CCLockfreeFunc>
@@ -120,11 +607,19 @@ namespace cclockfree {
         }
 
         // Diagnostic allocations
+        //! c++11 new never align over max_align_t, align by Traits::HotDataAlignSize so the padding member keep its cache line
         void* operator new(size_t nSize) {
-            return Traits::malloc(nSize);
+            void* pRet = CCLockfreeAlignedMalloc<Traits>(nSize, GetNewAlignSize());
+            if (pRet == nullptr)
+                throw std::bad_alloc();
+            return pRet;
         }
         void operator delete(void* p) {
-            Traits::free(p);
+            CCLockfreeAlignedFree<Traits>(p);
+        }
+    protected:
+        static inline size_t GetNewAlignSize() {
+            return Traits::HotDataAlignSize > alignof(std::max_align_t) ? Traits::HotDataAlignSize : alignof(std::max_align_t);
         }
     };
 }
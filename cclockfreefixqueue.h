@@ -4,55 +4,519 @@
 
 // Compiler-specific likely/unlikely hints
 namespace cclockfree {
+    //! max slot count, the cursor distance of the fix queue is int32_t
+    static const uint32_t CCLockfreeFixQueueMaxSize = 0x40000000;
+    //! round up to power(2), clamp to CCLockfreeFixQueueMaxSize
+    inline uint32_t CCLockfreeFixQueueRoundSize(uint32_t nSize) {
+        if (nSize >= CCLockfreeFixQueueMaxSize)
+            return CCLockfreeFixQueueMaxSize;
+        uint32_t nRoundSize = 1;
+        while (nRoundSize < nSize)
+            nRoundSize <<= 1;
+        return nRoundSize;
+    }
+    //! slot array of CCLockfreeFixQueue, inline when the size is known at compile time
+    template<class Slot, uint32_t nFixSize, class Traits>
+    struct CCLockfreeFixSlotArray {
+        Slot                                m_slot[nFixSize];
+
+        inline void Alloc(uint32_t nSize) {
+            assert(nSize == nFixSize);
+        }
+        inline void Free() {
+        }
+        inline uint32_t GetSize() const {
+            return nFixSize;
+        }
+        inline Slot& operator[](uint32_t nIndex) {
+            return m_slot[nIndex];
+        }
+    };
+    //! defaultfixsize 0, the size is given at construction time and the slot is alloc by Traits with Traits::FixQueueBufferAlignSize
+    template<class Slot, class Traits>
+    struct CCLockfreeFixSlotArray<Slot, 0, Traits> {
+        Slot*                               m_pSlot;
+        uint32_t                            m_nSize;
+
+        inline void Alloc(uint32_t nSize) {
+            m_nSize = nSize;
+            m_pSlot = (Slot*)CCLockfreeAlignedMalloc<Traits>(sizeof(Slot) * nSize,
+                Traits::FixQueueBufferAlignSize > alignof(Slot) ? Traits::FixQueueBufferAlignSize : alignof(Slot));
+            //the constructor can not return the fail, like new
+            if (m_pSlot == nullptr)
+                throw std::bad_alloc();
+        }
+        inline void Free() {
+            CCLockfreeAlignedFree<Traits>(m_pSlot);
+            m_pSlot = nullptr;
+        }
+        inline uint32_t GetSize() const {
+            return m_nSize;
+        }
+        inline Slot& operator[](uint32_t nIndex) {
+            return m_pSlot[nIndex];
+        }
+    };
+
     //дֵ  defaultfixsize - defaultfixsize * 2 ֮
-    template<class T, uint32_t defaultfixsize = 32, class ObjectBaseClass = CCLockfreeObject<CCLockfreeFunc>>
+    //! defaultfixsize 0, the size is the construct parameter, the slot is on the heap and one instantiation for every size
+    template<class T, uint32_t defaultfixsize = 32, class Traits = CCLockfreeFunc, class ObjectBaseClass = CCLockfreeObject<Traits>>
     class CCLockfreeFixQueue : public ObjectBaseClass {
     public:
         struct StoreLockfreeFixQueue {
-            T                               m_data;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type m_data;
             std::atomic<uint8_t>            m_cWrite;
+
+            inline T* GetData() {
+                return reinterpret_cast<T*>(&m_data);
+            }
+        };
+        //! T and flag in the same slot
+        struct StoreLockfreeFixQueueArray {
+            CCLockfreeFixSlotArray<StoreLockfreeFixQueue, defaultfixsize, Traits> m_slot;
+
+            inline void Alloc(uint32_t nSize) {
+                m_slot.Alloc(nSize);
+            }
+            inline void Free() {
+                m_slot.Free();
+            }
+            inline uint32_t GetSize() const {
+                return m_slot.GetSize();
+            }
+            inline T* GetData(uint32_t nIndex) {
+                return m_slot[nIndex].GetData();
+            }
+            inline std::atomic<uint8_t>& GetFlag(uint32_t nIndex) {
+                return m_slot[nIndex].m_cWrite;
+            }
+        };
+        //! Traits::SplitSlotLayout, all the T then all the flag, no padding between T and the flag
+        struct StoreLockfreeFixQueueSplit {
+            typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type StoreT;
+            CCLockfreeFixSlotArray<StoreT, defaultfixsize, Traits> m_data;
+            CCLockfreeFixSlotArray<std::atomic<uint8_t>, defaultfixsize, Traits> m_cWrite;
+
+            inline void Alloc(uint32_t nSize) {
+                m_data.Alloc(nSize);
+                m_cWrite.Alloc(nSize);
+            }
+            inline void Free() {
+                m_data.Free();
+                m_cWrite.Free();
+            }
+            inline uint32_t GetSize() const {
+                return m_data.GetSize();
+            }
+
+            inline T* GetData(uint32_t nIndex) {
+                return reinterpret_cast<T*>(&m_data[nIndex]);
+            }
+            inline std::atomic<uint8_t>& GetFlag(uint32_t nIndex) {
+                return m_cWrite[nIndex];
+            }
+        };
+        //! the slot operation on the flag layout
+        template<class Layout>
+        struct StoreLockfreeFixQueueFlag : public Layout {
+            inline void Init(uint32_t nSize) {
+                this->Alloc(nSize);
+                for (uint32_t i = 0; i < nSize; i++) {
+                    new (&this->GetFlag(i)) std::atomic<uint8_t>(0);
+                }
+            }
+            template<class... Args>
+            inline void Write(uint32_t nIndex, Args&&... args) {
+                atomic_backoff bPause;
+                std::atomic<uint8_t>& cWrite = this->GetFlag(nIndex);
+                while (cWrite.load(std::memory_order_relaxed)) {
+                    bPause.pause();
+                }
+                new (this->GetData(nIndex)) T(std::forward<Args>(args)...);
+                cWrite.store(true, std::memory_order_release);
+            }
+            inline void Read(uint32_t nIndex, T& value) {
+                atomic_backoff bPause;
+                std::atomic<uint8_t>& cWrite = this->GetFlag(nIndex);
+                while (!cWrite.load(std::memory_order_acquire)) {
+                    bPause.pause();
+                }
+                T* pData = this->GetData(nIndex);
+                value = std::move(*pData);
+                pData->~T();
+                cWrite.store(false, std::memory_order_release);
+            }
+            //! destroy the data not pop
+            inline void Destroy() {
+                if (!std::is_trivially_destructible<T>::value) {
+                    for (uint32_t i = 0; i < this->GetSize(); i++) {
+                        if (this->GetFlag(i).load(std::memory_order_relaxed))
+                            this->GetData(i)->~T();
+                    }
+                }
+                this->Free();
+            }
+        };
+        //! Traits::PointerSlot and T is a pointer, the slot is the pointer itself and nullptr is empty, so nullptr can not push
+        struct StoreLockfreeFixQueuePointer {
+            CCLockfreeFixSlotArray<std::atomic<T>, defaultfixsize, Traits> m_slot;
+
+            inline void Init(uint32_t nSize) {
+                m_slot.Alloc(nSize);
+                for (uint32_t i = 0; i < nSize; i++) {
+                    new (&m_slot[i]) std::atomic<T>(nullptr);
+                }
+            }
+            template<class... Args>
+            inline void Write(uint32_t nIndex, Args&&... args) {
+                T value(std::forward<Args>(args)...);
+                assert(value != nullptr);
+                atomic_backoff bPause;
+                while (m_slot[nIndex].load(std::memory_order_relaxed) != nullptr) {
+                    bPause.pause();
+                }
+                m_slot[nIndex].store(value, std::memory_order_release);
+            }
+            inline void Read(uint32_t nIndex, T& value) {
+                atomic_backoff bPause;
+                while ((value = m_slot[nIndex].load(std::memory_order_acquire)) == nullptr) {
+                    bPause.pause();
+                }
+                m_slot[nIndex].store(nullptr, std::memory_order_release);
+            }
+            inline void Destroy() {
+                m_slot.Free();
+            }
+        };
+        //! Traits::PackSmallSlot, small T share one uint64_t with the flag, 0 is empty and the low byte 1 is written
+        struct StoreLockfreeFixQueuePack {
+            typedef CCLockfreePackSlot<T, Traits> PackSlot;
+            CCLockfreeFixSlotArray<std::atomic<uint64_t>, defaultfixsize, Traits> m_slot;
+
+            inline void Init(uint32_t nSize) {
+                m_slot.Alloc(nSize);
+                for (uint32_t i = 0; i < nSize; i++) {
+                    new (&m_slot[i]) std::atomic<uint64_t>(0);
+                }
+            }
+            template<class... Args>
+            inline void Write(uint32_t nIndex, Args&&... args) {
+                uint64_t nSlot = PackSlot::Pack(T(std::forward<Args>(args)...), 1);
+                atomic_backoff bPause;
+                while (m_slot[nIndex].load(std::memory_order_relaxed) != 0) {
+                    bPause.pause();
+                }
+                m_slot[nIndex].store(nSlot, std::memory_order_release);
+            }
+            inline void Read(uint32_t nIndex, T& value) {
+                atomic_backoff bPause;
+                uint64_t nSlot;
+                while ((nSlot = m_slot[nIndex].load(std::memory_order_acquire)) == 0) {
+                    bPause.pause();
+                }
+                PackSlot::Unpack(nSlot, value);
+                m_slot[nIndex].store(0, std::memory_order_release);
+            }
+            inline void Destroy() {
+                m_slot.Free();
+            }
+        };
+        //! Traits::SequenceSlot, every slot have a sequence, push and pop only cas own cursor
+        //! slot n is free for the write position pos when sequence == pos, is readable when sequence == pos + 1
+        struct StoreLockfreeFixQueueSequence {
+            struct StoreSequenceSlot {
+                std::atomic<uint32_t>           m_nSequence;
+                typename std::aligned_storage<sizeof(T), alignof(T)>::type m_data;
+
+                inline T* GetData() {
+                    return reinterpret_cast<T*>(&m_data);
+                }
+            };
+            CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t   m_nEnqueue;
+            CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t   m_nDequeue;
+            CCLockfreeAlignAs(Traits, StoreSequenceSlot) CCLockfreeFixSlotArray<StoreSequenceSlot, defaultfixsize, Traits> m_slot;
+
+            inline void Init(uint32_t nSize) {
+                m_nEnqueue = 0;
+                m_nDequeue = 0;
+                m_slot.Alloc(nSize);
+                for (uint32_t i = 0; i < nSize; i++) {
+                    new (&m_slot[i].m_nSequence) std::atomic<uint32_t>(i);
+                }
+            }
+            template<class... Args>
+            inline bool TryWrite(Args&&... args) {
+                uint32_t nPos = m_nEnqueue;
+                uint32_t nMask = m_slot.GetSize() - 1;
+                StoreSequenceSlot* pSlot;
+                while (true) {
+                    pSlot = &m_slot[nPos & nMask];
+                    int32_t nDis = (int32_t)(pSlot->m_nSequence.load(std::memory_order_acquire) - nPos);
+                    if (nDis == 0) {
+                        if (CCLockfreeInterlockedCompareExchange(&m_nEnqueue, nPos, nPos + 1))
+                            break;
+                    }
+                    else if (nDis < 0) {
+                        //the slot not pop by last round, full
+                        return false;
+                    }
+                    nPos = m_nEnqueue;
+                }
+                new (pSlot->GetData()) T(std::forward<Args>(args)...);
+                pSlot->m_nSequence.store(nPos + 1, std::memory_order_release);
+                return true;
+            }
+            inline bool TryRead(T& value) {
+                uint32_t nPos = m_nDequeue;
+                uint32_t nMask = m_slot.GetSize() - 1;
+                StoreSequenceSlot* pSlot;
+                while (true) {
+                    pSlot = &m_slot[nPos & nMask];
+                    int32_t nDis = (int32_t)(pSlot->m_nSequence.load(std::memory_order_acquire) - (nPos + 1));
+                    if (nDis == 0) {
+                        if (CCLockfreeInterlockedCompareExchange(&m_nDequeue, nPos, nPos + 1))
+                            break;
+                    }
+                    else if (nDis < 0) {
+                        //the slot not push, empty
+                        return false;
+                    }
+                    nPos = m_nDequeue;
+                }
+                T* pData = pSlot->GetData();
+                value = std::move(*pData);
+                pData->~T();
+                pSlot->m_nSequence.store(nPos + nMask + 1, std::memory_order_release);
+                return true;
+            }
+            inline void Destroy() {
+                if (!std::is_trivially_destructible<T>::value) {
+                    for (uint32_t nPos = m_nDequeue; nPos != m_nEnqueue; nPos++) {
+                        m_slot[nPos & (m_slot.GetSize() - 1)].GetData()->~T();
+                    }
+                }
+                m_slot.Free();
+            }
+        };
+        //! Traits::OverwriteOldest, push never wait or fail for space, a full ring overwrite the oldest unread slot
+        //! slot sequence is pos * 2 + 1 when writing, pos * 2 + 2 when written, reader check it before and after the copy
+        //! T must be trivially copyable, a reader may copy the slot while a writer of the next round overwrite it
+        struct StoreLockfreeFixQueueOverwrite {
+            struct StoreOverwriteSlot {
+                std::atomic<uint32_t>           m_nSequence;
+                //the writing sequence of the pos which give up the slot, the reader skip the pos by it
+                std::atomic<uint32_t>           m_nAbandon;
+                typename std::aligned_storage<sizeof(T), alignof(T)>::type m_data;
+            };
+            CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t   m_nEnqueue;
+            CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t   m_nDequeue;
+            //the unread slot overwritten, count by the reader when it skip them
+            volatile uint32_t                                       m_nDrop;
+            CCLockfreeAlignAs(Traits, StoreOverwriteSlot) CCLockfreeFixSlotArray<StoreOverwriteSlot, defaultfixsize, Traits> m_slot;
+
+            inline void Init(uint32_t nSize) {
+                static_assert(std::is_trivially_copyable<T>::value, "Traits::OverwriteOldest need trivially copyable T error!");
+                m_nEnqueue = 0;
+                m_nDequeue = 0;
+                m_nDrop = 0;
+                m_slot.Alloc(nSize);
+                for (uint32_t i = 0; i < nSize; i++) {
+                    //the written sequence of pos i - nSize, not readable for pos i
+                    new (&m_slot[i].m_nSequence) std::atomic<uint32_t>((i - nSize) * 2 + 2);
+                    new (&m_slot[i].m_nAbandon) std::atomic<uint32_t>(0);
+                }
+            }
+            //! false when the slot is still written by the last round or taken by the next round, the value is drop
+            template<class... Args>
+            inline bool TryWrite(Args&&... args) {
+                T value(std::forward<Args>(args)...);
+                uint32_t nPos = CCLockfreeInterlockedIncrement(&m_nEnqueue);
+                StoreOverwriteSlot& slot = m_slot[nPos & (m_slot.GetSize() - 1)];
+                uint32_t nWriting = nPos * 2 + 1;
+                uint32_t nSequence = slot.m_nSequence.load(std::memory_order_relaxed);
+                do {
+                    if ((int32_t)(nSequence - nWriting) > 0)
+                        return false;
+                    if (nSequence & 1) {
+                        //the last round is still writing, the pos is never written, let the reader skip it
+                        slot.m_nAbandon.store(nWriting, std::memory_order_release);
+                        return false;
+                    }
+                } while (!slot.m_nSequence.compare_exchange_weak(nSequence, nWriting, std::memory_order_relaxed));
+                std::atomic_thread_fence(std::memory_order_release);
+                memcpy(&slot.m_data, &value, sizeof(T));
+                slot.m_nSequence.store(nWriting + 1, std::memory_order_release);
+                return true;
+            }
+            inline bool TryRead(T& value) {
+                uint32_t nSize = m_slot.GetSize();
+                uint32_t nPos = m_nDequeue;
+                while (true) {
+                    StoreOverwriteSlot& slot = m_slot[nPos & (nSize - 1)];
+                    uint32_t nWritten = nPos * 2 + 2;
+                    uint32_t nSequence = slot.m_nSequence.load(std::memory_order_acquire);
+                    int32_t nDis = (int32_t)(nSequence - nWritten);
+                    if (nDis == 0) {
+                        typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+                        memcpy(&data, &slot.m_data, sizeof(T));
+                        std::atomic_thread_fence(std::memory_order_acquire);
+                        if (slot.m_nSequence.load(std::memory_order_relaxed) == nSequence) {
+                            if (CCLockfreeInterlockedCompareExchange(&m_nDequeue, nPos, nPos + 1)) {
+                                memcpy((void*)&value, &data, sizeof(T));
+                                return true;
+                            }
+                            nPos = m_nDequeue;
+                        }
+                        //torn, the next round is writing, skip by nDis > 0
+                        continue;
+                    }
+                    uint32_t nEnqueue = m_nEnqueue;
+                    uint32_t nSkipPos = nEnqueue - nSize;
+                    uint32_t nDrop = 0;
+                    if (nDis < 0 && (int32_t)(nEnqueue - nPos) <= (int32_t)nSize) {
+                        //not written yet, wait the writer unless it give up the pos
+                        if (slot.m_nAbandon.load(std::memory_order_acquire) != nWritten - 1)
+                            return false;
+                        nSkipPos = nPos + 1;
+                    }
+                    //overwritten, skip to the oldest slot which can be still there
+                    else {
+                        if ((int32_t)(nSkipPos - nPos) <= 0)
+                            nSkipPos = nPos + 1;
+                        nDrop = nSkipPos - nPos;
+                    }
+                    if (CCLockfreeInterlockedCompareExchange(&m_nDequeue, nPos, nSkipPos)) {
+                        if (nDrop)
+                            CCLockfreeInterlockedAdd(&m_nDrop, nDrop);
+                        nPos = nSkipPos;
+                    }
+                    else {
+                        nPos = m_nDequeue;
+                    }
+                }
+            }
+            inline uint32_t GetDropCount() const {
+                return m_nDrop;
+            }
+            inline void Destroy() {
+                m_slot.Free();
+            }
         };
+        typedef typename std::conditional<Traits::OverwriteOldest, StoreLockfreeFixQueueOverwrite,
+            typename std::conditional<Traits::SequenceSlot, StoreLockfreeFixQueueSequence,
+            typename std::conditional<Traits::PointerSlot && std::is_pointer<T>::value, StoreLockfreeFixQueuePointer,
+            typename std::conditional<CCLockfreePackSlot<T, Traits>::value, StoreLockfreeFixQueuePack,
+            StoreLockfreeFixQueueFlag<typename std::conditional<Traits::SplitSlotLayout, StoreLockfreeFixQueueSplit, StoreLockfreeFixQueueArray>::type>>::type>::type>::type>::type StoreData;
+        //! the sequence and overwrite store keep the cursor and push/pop by themselves
+        typedef std::integral_constant<bool, Traits::SequenceSlot || Traits::OverwriteOldest> StoreCursor;
     public:
-        CCLockfreeFixQueue(){
+        //! nSize is used when defaultfixsize is 0 and round up to power(2), at most CCLockfreeFixQueueMaxSize
+        //! throw std::bad_alloc when the slot can not alloc
+        CCLockfreeFixQueue(uint32_t nSize = defaultfixsize){
             static_assert((defaultfixsize & (defaultfixsize - 1)) == 0,
                 "defaultfixsize is not power(2) error!");
-            m_nSpace = defaultfixsize;
+            if (defaultfixsize != 0) {
+                nSize = defaultfixsize;
+            }
+            else {
+                nSize = CCLockfreeFixQueueRoundSize(nSize);
+            }
+            m_nMask = nSize - 1;
+            m_nSpace = nSize;
             m_nCanRead = 0;
             m_nPreWrite = 0;
             m_nRead = 0;
-            memset(m_pData, 0, sizeof(StoreLockfreeFixQueue) * defaultfixsize);
+            m_data.Init(nSize);
         }
         virtual ~CCLockfreeFixQueue() {
+            m_data.Destroy();
+        }
+        uint32_t GetCapacity() const {
+            return GetMask() + 1;
         }
+        //! Traits::PointerSlot pointer T return false for nullptr, the slot of nullptr is empty
         inline bool Push(const T& value) {
+            return Emplace(value);
+        }
+        inline bool Push(T&& value) {
+            return Emplace(std::move(value));
+        }
+        //! construct T in the slot, args is not used when return false
+        template<class... Args>
+        inline bool Emplace(Args&&... args) {
+            return EmplacePointer(std::is_same<StoreData, StoreLockfreeFixQueuePointer>(), std::forward<Args>(args)...);
+        }
+        inline bool Pop(T& value) {
+            return PopSlot(StoreCursor(), value);
+        }
+        //! pointer queue only, return nullptr when empty
+        template<class P = T>
+        inline typename std::enable_if<std::is_pointer<P>::value, P>::type Pop() {
+            P value;
+            return Pop(value) ? value : nullptr;
+        }
+        //! Traits::OverwriteOldest only, the count of the slot overwritten before pop
+        template<class S = StoreData>
+        inline typename std::enable_if<std::is_same<S, StoreLockfreeFixQueueOverwrite>::value, uint32_t>::type GetDropCount() const {
+            return m_data.GetDropCount();
+        }
+        //! spin Traits::WaitSpinCount times then park until push
+        void WaitPop(T& value) {
+            m_eventCount.WaitFor([&]() { return Pop(value); }, Traits::WaitSpinCount, CCLockfreeEventCount::Infinite);
+        }
+        //! return false when nothing to pop after nMilliseconds
+        bool WaitPopFor(T& value, uint32_t nMilliseconds) {
+            return m_eventCount.WaitFor([&]() { return Pop(value); }, Traits::WaitSpinCount, nMilliseconds);
+        }
+    protected:
+        //! compile time size keep the mask as constant
+        inline uint32_t GetMask() const {
+            return defaultfixsize != 0 ? defaultfixsize - 1 : m_nMask;
+        }
+        //! refuse nullptr before the slot is reserve
+        template<class... Args>
+        inline bool EmplacePointer(std::true_type, Args&&... args) {
+            T value(std::forward<Args>(args)...);
+            if (CCLockfreequeueUnLikely(value == nullptr))
+                return false;
+            return EmplaceSlot(StoreCursor(), value);
+        }
+        template<class... Args>
+        inline bool EmplacePointer(std::false_type, Args&&... args) {
+            return EmplaceSlot(StoreCursor(), std::forward<Args>(args)...);
+        }
+        template<class... Args>
+        inline bool EmplaceSlot(std::true_type, Args&&... args) {
+            if (CCLockfreequeueLikely(m_data.TryWrite(std::forward<Args>(args)...))) {
+                //the slot is publish by a release store, the waiter check must not pass it
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_eventCount.NotifyAfterBarrier();
+                return true;
+            }
+            return false;
+        }
+        inline bool PopSlot(std::true_type, T& value) {
+            return m_data.TryRead(value);
+        }
+        template<class... Args>
+        inline bool EmplaceSlot(std::false_type, Args&&... args) {
             int32_t nSpace = (int32_t)CCLockfreeInterlockedDecrement(&m_nSpace);
             if (CCLockfreequeueLikely(nSpace > 0)) {
-                atomic_backoff bPause;
-                StoreLockfreeFixQueue& node = m_pData[CCLockfreeInterlockedIncrement(&m_nPreWrite) % defaultfixsize];
-                while (node.m_cWrite.load(std::memory_order_relaxed)) {
-                    bPause.pause();
-                }
-                node.m_data = value;
-                node.m_cWrite.store(true, std::memory_order_release);
+                m_data.Write(CCLockfreeInterlockedIncrement(&m_nPreWrite) & GetMask(), std::forward<Args>(args)...);
                 CCLockfreeInterlockedIncrement(&m_nCanRead);
+                m_eventCount.NotifyAfterBarrier();
                 return true;
             }
             CCLockfreeInterlockedIncrement(&m_nSpace);
             return false;
         }
-        inline bool Pop(T& value) {
+        inline bool PopSlot(std::false_type, T& value) {
             int32_t nCanRead = (int32_t)m_nCanRead;
             if (nCanRead <= 0)
                 return false;
             nCanRead = CCLockfreeInterlockedDecrement(&m_nCanRead);
             if (CCLockfreequeueLikely(nCanRead > 0)) {
-                atomic_backoff bPause;
-                StoreLockfreeFixQueue& node = m_pData[CCLockfreeInterlockedIncrement(&m_nRead) % defaultfixsize];
-                while (!node.m_cWrite.load(std::memory_order_acquire)) {
-                    bPause.pause();
-                }
-                value = node.m_data;
-                node.m_cWrite.store(false, std::memory_order_release);
+                m_data.Read(CCLockfreeInterlockedIncrement(&m_nRead) & GetMask(), value);
                 CCLockfreeInterlockedIncrement(&m_nSpace);
                 return true;
             }
@@ -60,11 +524,163 @@ namespace cclockfree {
             return false;
         }
     protected:
-        volatile uint32_t           m_nSpace;
-        volatile uint32_t           m_nCanRead;
-        volatile uint32_t           m_nPreWrite;
-        volatile uint32_t           m_nRead;
-        StoreLockfreeFixQueue       m_pData[defaultfixsize];
+        //! size - 1, only read when defaultfixsize is 0
+        uint32_t                                                                m_nMask;
+        //m_nSpace and m_nCanRead are touched by both side, every counter have own cache line when padding
+        //Traits::SequenceSlot not use the counter, the cursor is in m_data
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t                   m_nSpace;
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t                   m_nCanRead;
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t                   m_nPreWrite;
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t                   m_nRead;
+        //WaitPop park here
+        CCLockfreeAlignAs(Traits, CCLockfreeEventCount) CCLockfreeEventCount    m_eventCount;
+        CCLockfreeAlignAs(Traits, StoreData) StoreData                          m_data;
+    };
+    //! every consumer see every item, each consumer have own read cursor and push wait for the slowest consumer
+    //! consumer nConsumer in [0, nConsumerCount) is pop by one thread, the item is copy out and destroy when the slot is reused
+    //! defaultfixsize 0, the size is the construct parameter like CCLockfreeFixQueue
+    template<class T, uint32_t defaultfixsize = 32, class Traits = CCLockfreeFunc, class ObjectBaseClass = CCLockfreeObject<Traits>>
+    class CCLockfreeBroadcastFixQueue : public ObjectBaseClass {
+    public:
+        //! slot is readable for pos when sequence == pos + 1, the T of pos - size is still in the slot until pos write
+        struct StoreBroadcastSlot {
+            std::atomic<uint32_t>           m_nSequence;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type m_data;
+
+            inline T* GetData() {
+                return reinterpret_cast<T*>(&m_data);
+            }
+        };
+        struct StoreBroadcastCursor {
+            CCLockfreeAlignAs(Traits, uint32_t) std::atomic<uint32_t> m_nRead;
+        };
+    public:
+        //! nSize is used when defaultfixsize is 0 and round up to power(2), at most CCLockfreeFixQueueMaxSize
+        CCLockfreeBroadcastFixQueue(uint32_t nConsumerCount, uint32_t nSize = defaultfixsize) {
+            static_assert((defaultfixsize & (defaultfixsize - 1)) == 0,
+                "defaultfixsize is not power(2) error!");
+            assert(nConsumerCount > 0);
+            if (defaultfixsize != 0) {
+                nSize = defaultfixsize;
+            }
+            else {
+                nSize = CCLockfreeFixQueueRoundSize(nSize);
+            }
+            m_nEnqueue = 0;
+            m_nGate = 0;
+            m_slot.Alloc(nSize);
+            for (uint32_t i = 0; i < nSize; i++) {
+                //written by pos i - 2 * nSize, neither readable nor hold T for the first round
+                new (&m_slot[i].m_nSequence) std::atomic<uint32_t>(i - 2 * nSize + 1);
+            }
+            m_nConsumerCount = nConsumerCount;
+            m_pCursor = (StoreBroadcastCursor*)CCLockfreeAlignedMalloc<Traits>(sizeof(StoreBroadcastCursor) * nConsumerCount, alignof(StoreBroadcastCursor));
+            if (m_pCursor == nullptr) {
+                m_slot.Free();
+                throw std::bad_alloc();
+            }
+            for (uint32_t i = 0; i < nConsumerCount; i++) {
+                new (&m_pCursor[i].m_nRead) std::atomic<uint32_t>(0);
+            }
+        }
+        virtual ~CCLockfreeBroadcastFixQueue() {
+            if (!std::is_trivially_destructible<T>::value) {
+                //the slot keep the last round until reuse
+                uint32_t nSize = GetCapacity();
+                uint32_t nEnqueue = m_nEnqueue;
+                for (uint32_t i = 0; i < nSize; i++) {
+                    uint32_t nDis = nEnqueue - (m_slot[i].m_nSequence.load(std::memory_order_relaxed) - 1);
+                    if (nDis > 0 && nDis <= nSize)
+                        m_slot[i].GetData()->~T();
+                }
+            }
+            m_slot.Free();
+            CCLockfreeAlignedFree<Traits>(m_pCursor);
+        }
+        uint32_t GetCapacity() const {
+            return m_slot.GetSize();
+        }
+        uint32_t GetConsumerCount() const {
+            return m_nConsumerCount;
+        }
+        inline bool Push(const T& value) {
+            return Emplace(value);
+        }
+        inline bool Push(T&& value) {
+            return Emplace(std::move(value));
+        }
+        //! false when the slowest consumer not leave the slot, args is not used when return false
+        template<class... Args>
+        inline bool Emplace(Args&&... args) {
+            uint32_t nSize = GetCapacity();
+            uint32_t nPos = m_nEnqueue;
+            while (true) {
+                if (CCLockfreequeueUnLikely((int32_t)(nPos - m_nGate) >= (int32_t)nSize)) {
+                    //the cache gate is full, check all the consumer
+                    uint32_t nGate = GetMinCursor(nPos);
+                    m_nGate = nGate;
+                    if ((int32_t)(nPos - nGate) >= (int32_t)nSize) {
+                        uint32_t nEnqueue = m_nEnqueue;
+                        if (nEnqueue == nPos)
+                            return false;
+                        nPos = nEnqueue;
+                        continue;
+                    }
+                }
+                if (CCLockfreeInterlockedCompareExchange(&m_nEnqueue, nPos, nPos + 1))
+                    break;
+                nPos = m_nEnqueue;
+            }
+            StoreBroadcastSlot& slot = m_slot[nPos & (nSize - 1)];
+            if (slot.m_nSequence.load(std::memory_order_relaxed) == nPos - nSize + 1)
+                slot.GetData()->~T();
+            new (slot.GetData()) T(std::forward<Args>(args)...);
+            slot.m_nSequence.store(nPos + 1, std::memory_order_release);
+            //the waiter check must not pass the release store of the slot
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_eventCount.NotifyAfterBarrier(true);
+            return true;
+        }
+        //! copy the next item of nConsumer
+        inline bool Pop(uint32_t nConsumer, T& value) {
+            std::atomic<uint32_t>& nRead = m_pCursor[nConsumer].m_nRead;
+            uint32_t nPos = nRead.load(std::memory_order_relaxed);
+            StoreBroadcastSlot& slot = m_slot[nPos & (GetCapacity() - 1)];
+            if (slot.m_nSequence.load(std::memory_order_acquire) != nPos + 1)
+                return false;
+            value = *slot.GetData();
+            //the producer can reuse the slot after the cursor pass it
+            nRead.store(nPos + 1, std::memory_order_release);
+            return true;
+        }
+        //! spin Traits::WaitSpinCount times then park until push
+        void WaitPop(uint32_t nConsumer, T& value) {
+            m_eventCount.WaitFor([&]() { return Pop(nConsumer, value); }, Traits::WaitSpinCount, CCLockfreeEventCount::Infinite);
+        }
+        //! return false when nothing to pop after nMilliseconds
+        bool WaitPopFor(uint32_t nConsumer, T& value, uint32_t nMilliseconds) {
+            return m_eventCount.WaitFor([&]() { return Pop(nConsumer, value); }, Traits::WaitSpinCount, nMilliseconds);
+        }
+    protected:
+        //! the cursor of the slowest consumer, the cursor after nPos is count as nPos
+        uint32_t GetMinCursor(uint32_t nPos) {
+            int32_t nMaxDis = 0;
+            for (uint32_t i = 0; i < m_nConsumerCount; i++) {
+                int32_t nDis = (int32_t)(nPos - m_pCursor[i].m_nRead.load(std::memory_order_acquire));
+                if (nDis > nMaxDis)
+                    nMaxDis = nDis;
+            }
+            return nPos - nMaxDis;
+        }
+    protected:
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t                   m_nEnqueue;
+        //the slowest cursor seen by the producer, only reload when the slot reach it
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t                   m_nGate;
+        uint32_t                                                                m_nConsumerCount;
+        StoreBroadcastCursor*                                                   m_pCursor;
+        //WaitPop park here
+        CCLockfreeAlignAs(Traits, CCLockfreeEventCount) CCLockfreeEventCount    m_eventCount;
+        CCLockfreeAlignAs(Traits, StoreBroadcastSlot) CCLockfreeFixSlotArray<StoreBroadcastSlot, defaultfixsize, Traits> m_slot;
     };
 }
 
@@ -6,8 +6,17 @@
 
 // Compiler-specific likely/unlikely hints
 namespace cclockfree {
+    enum CCLockfreeQueueMode {
+        //! multi producer multi consumer
+        CCLockfreeQueueMode_MPMC = 0,
+        //! single producer single consumer, no interlocked on the hot path
+        CCLockfreeQueueMode_SPSC = 1,
+        //! multi producer single consumer, the consumer walk the lanes with a private cursor
+        CCLockfreeQueueMode_MPSC = 2,
+    };
     struct CCLockfreeQueueFunc : CCLockfreeFunc {
         //! ͻУͬмٳͻ, 2ָ
+        //! default lane count when construct without lane count, 0 use std::thread::hardware_concurrency()
         static const uint8_t ThreadWriteIndexModeIndex = 4;
 
         //! 俪ʼʱindex
@@ -18,131 +27,476 @@ namespace cclockfree {
         //! block size, 2ָ
         static const uint32_t BlockDefaultPerSize = 16;
         //! 价ָ
+        //! max double times of the circle, after that the next circle keep the size, it is also limit by IndexType
         static const uint8_t CirclePointNumber = 25; //Ĭȡ log((0xFFFFFFFF + 1) / SpaceToAllocaBlockSize) - log(BlockDefaultPerSize);
+
+        //! index type, uint32_t wrap around like linux jiffies, uint64_t never wrap in practice
+        typedef uint32_t IndexType;
+
+        //! max count of drained circle pool keep for the next circle, 0 close the recycle
+        static const uint32_t RecycleCacheCount = 8;
+        //! max bytes of the recycle cache, the pool release to system when over it
+        static const size_t RecycleCacheMaxSize = 64 * 1024 * 1024;
+        //! milliseconds without read progress(check when pop nothing), then release the recycle cache, 0 never release
+        static const uint32_t RecycleIdleMilliseconds = 1000;
+        //! 0 close, the consumer alloc the pool of the next circle into the recycle cache when the lane size pass the percent of the write circle
+        //! the producer make the circle full take it instead of malloc and reset the flag, need RecycleCacheCount
+        static const uint32_t PrepareCirclePercent = 0;
+        //! the producer wait the next circle grow by the other producer so many yield, then alloc one without the recycle cache to help
+        static const uint32_t GrowHelpYieldTimes = 1024;
+
+        //! consumer only claim the index which push is finish, a descheduled producer never block the consumer behind it
+        static const bool CommittedWrite = false;
+        //! CommittedWrite only, power(2), the producer wait when the commit index fall behind so much
+        static const uint32_t CommitRingSize = 4096;
+
+        //! ProducerToken buffer size, every Flush reserve the index once for all the buffer
+        static const uint32_t ProducerTokenSize = 32;
+
+        //! thread mode, the single side only one thread can call
+        static const CCLockfreeQueueMode QueueMode = CCLockfreeQueueMode_MPMC;
+        //! the single producer has no interlocked op, it need a full fence every push to wake WaitPop, false to skip it(WaitPop can not use)
+        static const bool SingleProducerWaitPop = true;
+    };
+    struct CCLockfreeQueue64Func : CCLockfreeQueueFunc {
+        typedef uint64_t IndexType;
+        //! the circle size is uint32_t, 32 << 26 = 0x80000000
+        static const uint8_t CirclePointNumber = 26;
+    };
+    struct CCLockfreeQueuePaddingFunc : CCLockfreeQueueFunc {
+        static const size_t HotDataAlignSize = 64;
+    };
+    struct CCLockfreeQueueHardwareFunc : CCLockfreeQueueFunc {
+        static const uint8_t ThreadWriteIndexModeIndex = 0;
+    };
+    struct CCLockfreeQueueCommittedFunc : CCLockfreeQueueFunc {
+        static const bool CommittedWrite = true;
+    };
+    struct CCLockfreeQueueSPSCFunc : CCLockfreeQueueFunc {
+        static const CCLockfreeQueueMode QueueMode = CCLockfreeQueueMode_SPSC;
+        //! one lane keep the producer and consumer walk the same circle in order
+        static const uint8_t ThreadWriteIndexModeIndex = 1;
+        static const bool SingleProducerWaitPop = false;
+    };
+    struct CCLockfreeQueueMPSCFunc : CCLockfreeQueueFunc {
+        static const CCLockfreeQueueMode QueueMode = CCLockfreeQueueMode_MPSC;
+    };
+    struct CCLockfreeQueuePackFunc : CCLockfreeQueueFunc {
+        static const bool PackSmallSlot = true;
+    };
+    struct CCLockfreeQueuePointerFunc : CCLockfreeQueueFunc {
+        static const bool PointerSlot = true;
+    };
+    struct CCLockfreeQueuePrepareFunc : CCLockfreeQueueFunc {
+        static const uint32_t PrepareCirclePercent = 50;
+    };
+    //! the circle pool is map from the system, the page is zero and touch when the producer first write it
+    struct CCLockfreeQueuePageFunc : CCLockfreeQueueFunc {
+        static inline void* malloc(size_t size) { return CCLockfreePageAlloc<false>::malloc(size); }
+        static inline void free(void* ptr) { return CCLockfreePageAlloc<false>::free(ptr); }
+        static const bool MallocZeroMemory = true;
+    };
+    struct CCLockfreeQueueHugePageFunc : CCLockfreeQueuePageFunc {
+        static inline void* malloc(size_t size) { return CCLockfreePageAlloc<true>::malloc(size); }
+        static inline void free(void* ptr) { return CCLockfreePageAlloc<true>::free(ptr); }
+    };
+    //! the circle pool is bind to nNumaNode, new the queue on a thread run on the node(CCLockfreeNumaRunOnNode) to first touch the lane
+    template<int nNumaNode>
+    struct CCLockfreeQueueNumaFunc : CCLockfreeQueuePageFunc {
+        static inline void* malloc(size_t size) { return CCLockfreePageAlloc<false, nNumaNode>::malloc(size); }
+        static inline void free(void* ptr) { return CCLockfreePageAlloc<false, nNumaNode>::free(ptr); }
     };
 
 #define uint32_t_after(a, b)    ((int32_t)(b) - (int32_t)(a) < 0)           //is a after b, linux jiffies
     //ÿռ任ʱķ
     template<class T, class Traits = CCLockfreeQueueFunc, class ObjectBaseClass = CCLockfreeObject<Traits>>
     class CCLockfreeQueue : public ObjectBaseClass {
+    public:
+        typedef typename Traits::IndexType IndexType;
+        //! is a after b
+        static inline bool IndexAfter(IndexType a, IndexType b) {
+            return (typename std::make_signed<IndexType>::type)(b - a) < 0;
+        }
+    protected:
+        //! the pool of a circle, nTotalSize T then nTotalSize flag in one block
+        //! the flag is dense so the half circle check can scan it by SIMD
+        //! flag 0 never write, (nSign & 0xF0) pop in the round of nSign, nSign push in the round
+        struct StoreFlagData {
+            typedef std::atomic<uint8_t> FlagType;
+            static inline size_t GetPoolSize(uint32_t nTotalSize) {
+                return (size_t)nTotalSize * (sizeof(T) + sizeof(FlagType));
+            }
+            inline T* GetData() {
+                return reinterpret_cast<T*>(this);
+            }
+            inline FlagType* GetFlag(uint32_t nTotalSize) {
+                return reinterpret_cast<FlagType*>(reinterpret_cast<char*>(this) + (size_t)nTotalSize * sizeof(T));
+            }
+            static inline void ResetFlag(StoreFlagData* pPool, uint32_t nTotalSize) {
+                FlagType* pFlag = pPool->GetFlag(nTotalSize);
+                for (uint32_t i = 0; i < nTotalSize; i++) {
+                    new (&pFlag[i]) FlagType(0);
+                }
+            }
+            template<class... Args>
+            static inline void WriteSlot(StoreFlagData* pPool, FlagType* pFlag, uint32_t nOffset, uint8_t nSign, Args&&... args) {
+                new (&pPool->GetData()[nOffset]) T(std::forward<Args>(args)...);
+                pFlag[nOffset].store(nSign, std::memory_order_release);
+            }
+            static inline void ReadSlot(StoreFlagData* pPool, FlagType* pFlag, uint32_t nOffset, uint8_t nSign, T& value) {
+                atomic_backoff bPause;
+                while (pFlag[nOffset].load(std::memory_order_acquire) != nSign) {
+                    bPause.pause();
+                }
+                T* pData = &pPool->GetData()[nOffset];
+                value = std::move(*pData);
+                pData->~T();
+                pFlag[nOffset].store(nSign & 0xF0, std::memory_order_release);
+            }
+            static inline uint32_t FindNotEqual(FlagType* pFlag, uint32_t nCount, uint8_t nValue, uint8_t nMask) {
+                return CCLockfreeFindFlagNotEqual(pFlag, nCount, nValue, nMask);
+            }
+            //! destroy the data not pop
+            static inline void DestroyData(StoreFlagData* pPool, FlagType* pFlag, uint32_t nTotalSize) {
+                if (!std::is_trivially_destructible<T>::value) {
+                    for (uint32_t i = 0; i < nTotalSize; i++) {
+                        if (pFlag[i].load(std::memory_order_relaxed) & 0x01)
+                            pPool->GetData()[i].~T();
+                    }
+                }
+            }
+        };
+        //! Traits::PointerSlot and T is a pointer, the slot is the pointer itself, half the size and one store less than StoreFlagData
+        //! slot 0 never write, (nSign & 0xF0) pop in the round of nSign, other value is the pointer push in the round
+        //! so nullptr(and the address under MaxSign) can not push, the push check it by CanWrite before reserve the index
+        struct StorePointerData {
+            typedef std::atomic<uintptr_t> FlagType;
+            static const uintptr_t MaxSign = 0xFF;
+            static inline size_t GetPoolSize(uint32_t nTotalSize) {
+                return (size_t)nTotalSize * sizeof(FlagType);
+            }
+            inline FlagType* GetFlag(uint32_t) {
+                return reinterpret_cast<FlagType*>(this);
+            }
+            static inline void ResetFlag(StorePointerData* pPool, uint32_t nTotalSize) {
+                FlagType* pFlag = pPool->GetFlag(nTotalSize);
+                for (uint32_t i = 0; i < nTotalSize; i++) {
+                    new (&pFlag[i]) FlagType(0);
+                }
+            }
+            static inline bool CanWrite(T value) {
+                return (uintptr_t)value > MaxSign;
+            }
+            template<class... Args>
+            static inline void WriteSlot(StorePointerData*, FlagType* pFlag, uint32_t nOffset, uint8_t, Args&&... args) {
+                uintptr_t nValue = (uintptr_t)T(std::forward<Args>(args)...);
+                assert(nValue > MaxSign);
+                pFlag[nOffset].store(nValue, std::memory_order_release);
+            }
+            static inline void ReadSlot(StorePointerData*, FlagType* pFlag, uint32_t nOffset, uint8_t nSign, T& value) {
+                atomic_backoff bPause;
+                uintptr_t nValue;
+                //the circle window make sure the pointer is push in the round we read
+                while ((nValue = pFlag[nOffset].load(std::memory_order_acquire)) <= MaxSign) {
+                    bPause.pause();
+                }
+                value = (T)nValue;
+                pFlag[nOffset].store(nSign & 0xF0, std::memory_order_release);
+            }
+            //! the pointer is push in the round, so it match the mask 0xF0 and not match the exact pop sign
+            static inline uint32_t FindNotEqual(FlagType* pFlag, uint32_t nCount, uint8_t nValue, uint8_t nMask) {
+                for (uint32_t i = 0; i < nCount; i++) {
+                    uintptr_t nFlag = pFlag[i].load(std::memory_order_relaxed);
+                    if (nFlag <= MaxSign ? (nFlag & nMask) != nValue : nMask == 0xFF)
+                        return i;
+                }
+                return nCount;
+            }
+            static inline void DestroyData(StorePointerData*, FlagType*, uint32_t) {
+            }
+        };
+        //! Traits::PackSmallSlot, small T share one uint64_t with the flag, the low byte is the flag of StoreFlagData
+        struct StorePackData {
+            typedef std::atomic<uint64_t> FlagType;
+            typedef CCLockfreePackSlot<T, Traits> PackSlot;
+            static inline size_t GetPoolSize(uint32_t nTotalSize) {
+                return (size_t)nTotalSize * sizeof(FlagType);
+            }
+            inline FlagType* GetFlag(uint32_t) {
+                return reinterpret_cast<FlagType*>(this);
+            }
+            static inline void ResetFlag(StorePackData* pPool, uint32_t nTotalSize) {
+                FlagType* pFlag = pPool->GetFlag(nTotalSize);
+                for (uint32_t i = 0; i < nTotalSize; i++) {
+                    new (&pFlag[i]) FlagType(0);
+                }
+            }
+            template<class... Args>
+            static inline void WriteSlot(StorePackData*, FlagType* pFlag, uint32_t nOffset, uint8_t nSign, Args&&... args) {
+                pFlag[nOffset].store(PackSlot::Pack(T(std::forward<Args>(args)...), nSign), std::memory_order_release);
+            }
+            static inline void ReadSlot(StorePackData*, FlagType* pFlag, uint32_t nOffset, uint8_t nSign, T& value) {
+                atomic_backoff bPause;
+                uint64_t nSlot;
+                while ((uint8_t)(nSlot = pFlag[nOffset].load(std::memory_order_acquire)) != nSign) {
+                    bPause.pause();
+                }
+                PackSlot::Unpack(nSlot, value);
+                pFlag[nOffset].store(nSign & 0xF0, std::memory_order_release);
+            }
+            static inline uint32_t FindNotEqual(FlagType* pFlag, uint32_t nCount, uint8_t nValue, uint8_t nMask) {
+                for (uint32_t i = 0; i < nCount; i++) {
+                    if (((uint8_t)pFlag[i].load(std::memory_order_relaxed) & nMask) != nValue)
+                        return i;
+                }
+                return nCount;
+            }
+            static inline void DestroyData(StorePackData*, FlagType*, uint32_t) {
+            }
+        };
+        typedef typename std::conditional<Traits::PointerSlot && std::is_pointer<T>::value, StorePointerData,
+            typename std::conditional<CCLockfreePackSlot<T, Traits>::value, StorePackData, StoreFlagData>::type>::type StoreData;
+        typedef typename StoreData::FlagType FlagType;
+        //! the pointer slot refuse some value, check it before reserve the index
+        typedef std::is_same<StoreData, StorePointerData> CheckWrite;
+        //! drained pool of all lanes, consumer put it back and producer take it when the circle is full
+        struct CircleRecycle {
+            struct CacheItem {
+                StoreData*              m_pPool;
+                uint32_t                m_nTotalSize;
+            };
+            CircleRecycle() : m_lock(0), m_nCount(0), m_nCacheSize(0) {
+            }
+            ~CircleRecycle() {
+                ReleaseAll();
+            }
+            //! the flag must be reset, return false if the cache is full
+            //! the circle only grow, so the smaller pool is drop first when the cache is full
+            bool PutPool(StoreData* pPool, uint32_t nTotalSize) {
+                size_t nSize = StoreData::GetPoolSize(nTotalSize);
+                bool bRet = false;
+                Lock();
+                while (m_nCount > 0 && (m_nCount >= Traits::RecycleCacheCount || m_nCacheSize + nSize > Traits::RecycleCacheMaxSize)) {
+                    uint32_t nMin = 0;
+                    for (uint32_t i = 1; i < m_nCount; i++) {
+                        if (m_items[i].m_nTotalSize < m_items[nMin].m_nTotalSize)
+                            nMin = i;
+                    }
+                    if (m_items[nMin].m_nTotalSize >= nTotalSize)
+                        break;
+                    Traits::free(m_items[nMin].m_pPool);
+                    m_nCacheSize -= StoreData::GetPoolSize(m_items[nMin].m_nTotalSize);
+                    m_items[nMin] = m_items[--m_nCount];
+                }
+                if (m_nCount < Traits::RecycleCacheCount && m_nCacheSize + nSize <= Traits::RecycleCacheMaxSize) {
+                    m_items[m_nCount].m_pPool = pPool;
+                    m_items[m_nCount].m_nTotalSize = nTotalSize;
+                    m_nCount++;
+                    m_nCacheSize += nSize;
+                    bRet = true;
+                }
+                m_lock.exchange(0);
+                return bRet;
+            }
+            //! take the smallest pool not less than nMinSize
+            StoreData* GetPool(uint32_t nMinSize, uint32_t& nTotalSize) {
+                if (m_nCount == 0)
+                    return nullptr;
+                StoreData* pRet = nullptr;
+                Lock();
+                uint32_t nFind = m_nCount;
+                for (uint32_t i = 0; i < m_nCount; i++) {
+                    if (m_items[i].m_nTotalSize >= nMinSize && (nFind == m_nCount || m_items[i].m_nTotalSize < m_items[nFind].m_nTotalSize))
+                        nFind = i;
+                }
+                if (nFind != m_nCount) {
+                    pRet = m_items[nFind].m_pPool;
+                    nTotalSize = m_items[nFind].m_nTotalSize;
+                    m_nCacheSize -= StoreData::GetPoolSize(nTotalSize);
+                    m_items[nFind] = m_items[--m_nCount];
+                }
+                m_lock.exchange(0);
+                return pRet;
+            }
+            void ReleaseAll() {
+                Lock();
+                for (uint32_t i = 0; i < m_nCount; i++) {
+                    Traits::free(m_items[i].m_pPool);
+                }
+                m_nCount = 0;
+                m_nCacheSize = 0;
+                m_lock.exchange(0);
+            }
+            size_t GetCacheSize() {
+                return m_nCacheSize;
+            }
+            uint32_t GetCount() {
+                return m_nCount;
+            }
+        protected:
+            inline void Lock() {
+                atomic_backoff bPause;
+                while (m_lock.exchange(1)) {
+                    bPause.pause();
+                }
+            }
+        protected:
+            std::atomic<char>           m_lock;
+            volatile uint32_t           m_nCount;
+            volatile size_t             m_nCacheSize;
+            CacheItem                   m_items[Traits::RecycleCacheCount ? Traits::RecycleCacheCount : 1];
+        };
     public:
         struct Circle {
         public:
-            static Circle* CreateCircle(uint32_t nPerSize, uint32_t nBeginIndex) {
+            static Circle* CreateCircle(uint32_t nPerSize, IndexType nBeginIndex, uint8_t nLaneShift) {
                 Circle* pRet = (Circle*)Traits::malloc(sizeof(Circle));
+                pRet->m_pNext = nullptr;
+                pRet->m_pPrev = nullptr;
+                //a reserved head circle count as grown from Traits::BlockDefaultPerSize
+                pRet->m_nGrowTimes = 0;
+                while (((uint32_t)Traits::BlockDefaultPerSize << pRet->m_nGrowTimes) < nPerSize)
+                    pRet->m_nGrowTimes++;
                 pRet->m_nResBeginIndex = nBeginIndex;
                 pRet->m_nBeginIndex = nBeginIndex;
                 pRet->m_nTotalSize = nPerSize * 2;
-                pRet->m_nCheckTotalSizeValue = pRet->m_nTotalSize * Traits::ThreadWriteIndexModeIndex;
+                pRet->m_nLaneShift = nLaneShift;
+                pRet->m_nCheckTotalSizeValue = (IndexType)pRet->m_nTotalSize << nLaneShift;
                 pRet->m_bNoWrite = false;
-                pRet->m_pPool = (StoreData*)Traits::malloc(pRet->m_nTotalSize * sizeof(StoreData));
-                memset(pRet->m_pPool, 0, sizeof(StoreData) * pRet->m_nTotalSize);
+                pRet->m_nGrowing = 0;
+                pRet->InitPool();
                 return pRet;
             }
-            static Circle* CreateNextCircle(Circle* pCircle) {
+            static Circle* CreateNextCircle(Circle* pCircle, CircleRecycle* pRecycle) {
                 Circle* pRet = (Circle*)Traits::malloc(sizeof(Circle));
+                pRet->m_pNext = nullptr;
+                pRet->m_pPrev = pCircle;
                 pRet->m_nResBeginIndex = pCircle->m_nBeginIndex + pCircle->m_nCheckTotalSizeValue;
                 pRet->m_nBeginIndex = pRet->m_nResBeginIndex;
-                pRet->m_nTotalSize = pCircle->m_nTotalSize * 2;
-                pRet->m_nCheckTotalSizeValue = pRet->m_nTotalSize * Traits::ThreadWriteIndexModeIndex;
+                pRet->m_nTotalSize = GetNextTotalSize(pCircle, pRet->m_nGrowTimes);
+                //the drained pool not less than the current size is enough, use it instead of growing
+                uint32_t nRecycleSize = 0;
+                pRet->m_pPool = pRecycle ? pRecycle->GetPool(pCircle->m_nTotalSize, nRecycleSize) : nullptr;
+                if (pRet->m_pPool) {
+                    pRet->m_nTotalSize = pCircle->m_nTotalSize;
+                    pRet->m_nGrowTimes = pCircle->m_nGrowTimes;
+                    while (pRet->m_nTotalSize < nRecycleSize) {
+                        pRet->m_nTotalSize *= 2;
+                        pRet->m_nGrowTimes++;
+                    }
+                }
+                pRet->m_nLaneShift = pCircle->m_nLaneShift;
+                pRet->m_nCheckTotalSizeValue = (IndexType)pRet->m_nTotalSize << pRet->m_nLaneShift;
                 pRet->m_bNoWrite = false;
-                pRet->m_pPool = (StoreData*)Traits::malloc(pRet->m_nTotalSize * sizeof(StoreData));
-                memset(pRet->m_pPool, 0, sizeof(StoreData) * pRet->m_nTotalSize);
+                pRet->m_nGrowing = 0;
+                if (pRet->m_pPool == nullptr)
+                    pRet->InitPool();
+                else
+                    pRet->m_pFlag = pRet->m_pPool->GetFlag(pRet->m_nTotalSize);
                 return pRet;
             }
+            //! the size and grow times of the circle after pCircle, double it until Traits::CirclePointNumber
+            static uint32_t GetNextTotalSize(Circle* pCircle, uint8_t& nGrowTimes) {
+                uint32_t nTotalSize = pCircle->m_nTotalSize;
+                nGrowTimes = pCircle->m_nGrowTimes;
+                //nDis must stay far from the sign bit of IndexType
+                const IndexType nMaxCheckTotalSizeValue = (IndexType)1 << (sizeof(IndexType) * 8 - 2);
+                if (nGrowTimes < Traits::CirclePointNumber && nTotalSize < 0x80000000 &&
+                    ((IndexType)nTotalSize << (pCircle->m_nLaneShift + 1)) <= nMaxCheckTotalSizeValue) {
+                    nTotalSize *= 2;
+                    nGrowTimes++;
+                }
+                return nTotalSize;
+            }
+            //! the circle lose the install race, nothing is written, pRecycle nullptr release the pool to system
+            static void DropCircle(Circle* pCircle, CircleRecycle* pRecycle) {
+                pCircle->RecyclePool(pRecycle);
+                Traits::free(pCircle);
+            }
             static void ReleaseCircle(Circle* pCircle) {
                 if (pCircle->m_pPool) {
+                    StoreData::DestroyData(pCircle->m_pPool, pCircle->m_pFlag, pCircle->m_nTotalSize);
                     Traits::free(pCircle->m_pPool);
                 }
                 Traits::free(pCircle);
             }
-            inline int PushPosition(const T& value, uint32_t nPreWriteIndex) {
-                uint32_t nGetBeginIndex = m_nBeginIndex;
-                uint32_t nDis = nPreWriteIndex - nGetBeginIndex;
+            template<class... Args>
+            inline int PushPosition(IndexType nPreWriteIndex, Args&&... args) {
+                IndexType nGetBeginIndex = m_nBeginIndex;
+                IndexType nDis = nPreWriteIndex - nGetBeginIndex;
 #ifdef _DEBUG
-                assert((nPreWriteIndex - nGetBeginIndex) % Traits::ThreadWriteIndexModeIndex == 0);
+                assert(((nPreWriteIndex - nGetBeginIndex) & ((1 << m_nLaneShift) - 1)) == 0);
 #endif
                 if (CCLockfreequeueUnLikely(nDis >= m_nCheckTotalSizeValue)) {
                     if (CCLockfreequeueUnLikely(nDis == m_nCheckTotalSizeValue)) {
-                        uint32_t nSetIndex = (nPreWriteIndex - m_nResBeginIndex) / Traits::ThreadWriteIndexModeIndex;
+                        //the next circle is growing, never turn over this one again
+                        if (m_bNoWrite)
+                            return 1;
+                        IndexType nSetIndex = (nPreWriteIndex - m_nResBeginIndex) >> m_nLaneShift;
                         uint8_t nCheckSign = ((nSetIndex * 2 / m_nTotalSize - 2) % 4 + 1) << 4;
                         //Ҫж ǰһǷѾȡ
                         uint32_t nPerSize = m_nTotalSize / 2;
-                        StoreData* pPoint = &m_pPool[nSetIndex % m_nTotalSize];
-                        uint8_t bWriteValue = 0;
-                        for (uint32_t i = 0; i < nPerSize; i++) {
-                            bWriteValue = pPoint[i].m_nWrite.load(std::memory_order_relaxed);
-                            if (bWriteValue != nCheckSign) {
-                                m_bNoWrite = true;
-                                atomic_backoff bPause;
-                                while (bWriteValue == 0) {
-                                    bPause.pause();
-                                    bWriteValue = pPoint[i].m_nWrite.load(std::memory_order_relaxed);
-                                }
-                                for (uint32_t j = i + 1; j < nPerSize; j++) {
-                                    while (0 == pPoint[j].m_nWrite.load(std::memory_order_relaxed))
-                                        bPause.pause();
-                                }
-                                pPoint = pPoint == m_pPool ? &m_pPool[nPerSize] : m_pPool;
-                                for (uint32_t j = 0; j < nPerSize; j++) {
-                                    while (0 == pPoint[j].m_nWrite.load(std::memory_order_relaxed))
-                                        bPause.pause();
-                                }
-                                return 1;
-                            }
+                        FlagType* pPoint = &m_pFlag[(uint32_t)(nSetIndex % m_nTotalSize)];
+                        uint32_t nNotRead = StoreData::FindNotEqual(pPoint, nPerSize, nCheckSign, 0xFF);
+                        if (nNotRead != nPerSize) {
+                            //the circle is full, m_nBeginIndex not change any more, every producer can make the next circle
+                            m_bNoWrite = true;
+                            return 1;
                         }
-                        m_nBeginIndex = nGetBeginIndex + nPerSize * Traits::ThreadWriteIndexModeIndex;
+                        //the pop of the old round happen before we write the slot
+                        atomic_thread_fence(std::memory_order_acquire);
+                        m_nBeginIndex = nGetBeginIndex + ((IndexType)nPerSize << m_nLaneShift);
+                    }
+                    else if ((typename std::make_signed<IndexType>::type)(nPreWriteIndex - m_nResBeginIndex) < 0) {
+                        //late producer see the next circle, the index is in the circle before
+                        return 3;
                     }
                     else {
                         return 2;
                     }
                 }
-                uint32_t nSetIndex = (nPreWriteIndex - m_nResBeginIndex) / Traits::ThreadWriteIndexModeIndex;
+                IndexType nSetIndex = (nPreWriteIndex - m_nResBeginIndex) >> m_nLaneShift;
                 uint8_t nSign = (((nSetIndex * 2 / m_nTotalSize) % 4 + 1) << 4) + 0x01;
-                StoreData& writeNode = m_pPool[nSetIndex % m_nTotalSize];
-                writeNode.m_pData = value;
-                writeNode.m_nWrite.store(nSign, std::memory_order_release);
+                StoreData::WriteSlot(m_pPool, m_pFlag, (uint32_t)(nSetIndex % m_nTotalSize), nSign, std::forward<Args>(args)...);
                 return 0;
             }
-            inline int PopPosition(T& value, uint32_t nReadIndex) {
-                uint32_t nGetBeginIndex = m_nBeginIndex;
-                uint32_t nDis = nReadIndex - nGetBeginIndex;
+            inline bool IsNoWrite() const {
+                return m_bNoWrite;
+            }
+            //! the producer turn over at m_nBeginIndex + m_nCheckTotalSizeValue
+            inline IndexType GetCheckTotalSizeValue() const {
+                return m_nCheckTotalSizeValue;
+            }
+            //! the consumer check the prepare every Traits::BlockDefaultPerSize slot
+            inline bool IsPrepareCheckIndex(IndexType nReadIndex) const {
+                return (((nReadIndex - m_nResBeginIndex) >> m_nLaneShift) & (Traits::BlockDefaultPerSize - 1)) == 0;
+            }
+            inline int PopPosition(T& value, IndexType nReadIndex) {
+                IndexType nGetBeginIndex = m_nBeginIndex;
+                IndexType nDis = nReadIndex - nGetBeginIndex;
 #ifdef _DEBUG
-                assert((nReadIndex - nGetBeginIndex) % Traits::ThreadWriteIndexModeIndex == 0);
+                assert(((nReadIndex - nGetBeginIndex) & ((1 << m_nLaneShift) - 1)) == 0);
 #endif
                 if (CCLockfreequeueUnLikely(nDis >= m_nCheckTotalSizeValue)) {
                     if (CCLockfreequeueUnLikely(nDis == m_nCheckTotalSizeValue)) {
                         if (m_bNoWrite) {
-                            uint32_t nSetIndex = (nReadIndex - m_nResBeginIndex) / Traits::ThreadWriteIndexModeIndex;
+                            IndexType nSetIndex = (nReadIndex - m_nResBeginIndex) >> m_nLaneShift;
                             uint8_t nCheckSign = ((nSetIndex * 2 / m_nTotalSize - 2) % 4 + 1) << 4;
                             uint32_t nPerSize = m_nTotalSize / 2;
-                            StoreData* pPoint = &m_pPool[nSetIndex % m_nTotalSize];
-                            atomic_backoff bPause;
-                            for (uint32_t i = 0; i < nPerSize; i++) {
-                                while (pPoint[i].m_nWrite.load(std::memory_order_relaxed) != nCheckSign)
-                                    bPause.pause();
-                            }
-                            pPoint = pPoint == m_pPool ? &m_pPool[nPerSize] : m_pPool;
+                            FlagType* pPoint = &m_pFlag[(uint32_t)(nSetIndex % m_nTotalSize)];
+                            WaitFlagEqual(pPoint, nPerSize, nCheckSign, 0xFF);
+                            pPoint = pPoint == m_pFlag ? &m_pFlag[nPerSize] : m_pFlag;
                             nCheckSign = ((nSetIndex * 2 / m_nTotalSize - 1) % 4 + 1) << 4;
-                            for (uint32_t j = 0; j < nPerSize; j++) {
-                                while (nCheckSign != pPoint[j].m_nWrite.load(std::memory_order_relaxed))
-                                    bPause.pause();
-                            }
+                            WaitFlagEqual(pPoint, nPerSize, nCheckSign, 0xFF);
                             return 1;
                         }
                         return 3;
                     }
                     return 2;
                 }
-                uint32_t nSetIndex = (nReadIndex - m_nResBeginIndex) / Traits::ThreadWriteIndexModeIndex;
+                IndexType nSetIndex = (nReadIndex - m_nResBeginIndex) >> m_nLaneShift;
                 uint8_t nSign = (((nSetIndex * 2 / m_nTotalSize) % 4 + 1) << 4) + 0x01;
-                StoreData& writeNode = m_pPool[nSetIndex % m_nTotalSize];
-                atomic_backoff bPause;
-                while (writeNode.m_nWrite.load(std::memory_order_acquire) != nSign) {
-                    bPause.pause();
-                }
-                value = writeNode.m_pData;
-                writeNode.m_nWrite.store(nSign & 0xF0, std::memory_order_release);
+                StoreData::ReadSlot(m_pPool, m_pFlag, (uint32_t)(nSetIndex % m_nTotalSize), nSign, value);
                 return 0;
             }
             inline void ReleasePool() {
@@ -150,61 +504,120 @@ namespace cclockfree {
                 Traits::free(m_pPool);
                 m_pPool = nullptr;
             }
+            //! all the data is pop, give the pool back to the recycle cache, release it when pRecycle is nullptr
+            inline void RecyclePool(CircleRecycle* pRecycle) {
+                if (Traits::RecycleCacheCount && pRecycle) {
+                    StoreData::ResetFlag(m_pPool, m_nTotalSize);
+                    if (pRecycle->PutPool(m_pPool, m_nTotalSize)) {
+                        m_pPool = nullptr;
+                        return;
+                    }
+                }
+                ReleasePool();
+            }
         protected:
-            struct StoreData {
-                T                           m_pData;
-                std::atomic<uint8_t>        m_nWrite;
-            };
-            uint32_t                        m_nResBeginIndex;
-            volatile uint32_t               m_nBeginIndex;
+            //only the flag is init, T is construct when push and destroy when pop
+            inline void InitPool() {
+                m_pPool = (StoreData*)Traits::malloc(StoreData::GetPoolSize(m_nTotalSize));
+                if (!Traits::MallocZeroMemory)
+                    StoreData::ResetFlag(m_pPool, m_nTotalSize);
+                m_pFlag = m_pPool->GetFlag(m_nTotalSize);
+            }
+            //! wait until all the (flag & nMask) of [0, nCount) equal nValue, skip the equal part by the SIMD scan
+            static inline void WaitFlagEqual(FlagType* pFlag, uint32_t nCount, uint8_t nValue, uint8_t nMask) {
+                atomic_backoff bPause;
+                uint32_t nEqual = 0;
+                while ((nEqual += StoreData::FindNotEqual(pFlag + nEqual, nCount - nEqual, nValue, nMask)) != nCount) {
+                    bPause.pause();
+                }
+            }
+            IndexType                       m_nResBeginIndex;
+            volatile IndexType              m_nBeginIndex;
             uint32_t                        m_nTotalSize;// m_nPerSize * 2
-            uint32_t                        m_nCheckTotalSizeValue;
+            IndexType                       m_nCheckTotalSizeValue;
+            //! lane count is 1 << m_nLaneShift
+            uint8_t                         m_nLaneShift;
+            uint8_t                         m_nGrowTimes;
             StoreData*                      m_pPool;
+            //! the flag array in m_pPool
+            FlagType*                       m_pFlag;
             volatile bool                   m_bNoWrite;
+        public:
+            //! 1 a producer claim to alloc the next circle, the other only help when it stall
+            volatile uint32_t               m_nGrowing;
+            //! next circle, the claim producer make it, or the helper when it stall, the first cas win
+            Circle* volatile                m_pNext;
+            //! the circle before, the late producer who see the next circle walk back, the pool is alive until its slot is pop
+            Circle*                         m_pPrev;
         };
         struct MicroQueue {
-            volatile uint8_t                                            m_nWriteCircle;
-            volatile uint8_t                                            m_nReadCircle;
-
-            Circle* volatile                                            m_pWrite;
-            Circle* volatile                                            m_pRead;
-            Circle* volatile                                            m_pCircle[Traits::CirclePointNumber];
+            //producer
+            CCLockfreeAlignAs(Traits, Circle*) Circle* volatile         m_pWrite;
+            //consumer
+            CCLockfreeAlignAs(Traits, Circle*) Circle* volatile         m_pRead;
+            //! the first circle, the circle head is keep until MicroQueue release, late producer may still read it
+            Circle*                                                     m_pHead;
+            CircleRecycle*                                              m_pRecycle;
+            //! Traits::PrepareCirclePercent only, the producer index of the queue and the last write circle prepare for
+            const volatile IndexType*                                   m_pPreWriteIndex;
+            Circle* volatile                                            m_pPrepareCircle;
+            //! the next circle install times
+            volatile uint32_t                                           m_nGrowCount;
             ~MicroQueue() {
-                for (int i = 0; i <= m_nWriteCircle; i++) {
-                    Circle::ReleaseCircle(m_pCircle[i]);
+                Circle* pCircle = m_pHead;
+                while (pCircle) {
+                    Circle* pNext = pCircle->m_pNext;
+                    Circle::ReleaseCircle(pCircle);
+                    pCircle = pNext;
                 }
             }
-            void InitMicroQueue(uint32_t nIndex) {
-                m_nWriteCircle = 0;
-                m_nReadCircle = 0;
-                m_pCircle[0] = Circle::CreateCircle(Traits::BlockDefaultPerSize, nIndex);
+            void InitMicroQueue(IndexType nIndex, uint8_t nLaneShift, CircleRecycle* pRecycle, const volatile IndexType* pPreWriteIndex) {
+                m_pRecycle = pRecycle;
+                m_pPreWriteIndex = pPreWriteIndex;
+                m_pPrepareCircle = nullptr;
+                m_nGrowCount = 0;
+                m_pHead = Circle::CreateCircle(Traits::BlockDefaultPerSize, nIndex, nLaneShift);
                 atomic_thread_fence(std::memory_order_release);
-                m_pWrite = m_pCircle[0];
+                m_pWrite = m_pHead;
                 m_pRead = m_pWrite;
             }
-            inline void PushMicroQueue(const T& value, uint32_t nPreWriteIndex) {
+            template<class... Args>
+            inline void PushMicroQueue(IndexType nPreWriteIndex, Args&&... args) {
                 atomic_backoff pause;
+                uint32_t nGrowWait = 0;
                 Circle* pCircle = m_pWrite;
                 atomic_thread_fence(std::memory_order_acquire);
                 //жϵǰд뻷Ƿ
                 while (true) {
-                    switch (m_pWrite->PushPosition(value, nPreWriteIndex)) {
+                    switch (pCircle->PushPosition(nPreWriteIndex, std::forward<Args>(args)...)) {
                     case 0: {
                         return;
                     }
                     case 1: {
-                        uint8_t nextCircle = m_nWriteCircle + 1;
-                        pCircle = Circle::CreateNextCircle(pCircle);
-                        m_pCircle[nextCircle] = pCircle;
-                        atomic_thread_fence(std::memory_order_release);
-                        m_pWrite = pCircle;
-                        m_nWriteCircle = nextCircle;
-                        pCircle->PushPosition(value, nPreWriteIndex);
-                        return;
+                        Circle* pNextCircle = InstallNextCircle(pCircle, nGrowWait >= Traits::GrowHelpYieldTimes);
+                        if (pNextCircle != pCircle) {
+                            pCircle = pNextCircle;
+                            continue;
+                        }
+                        break;
+                    }
+                    case 3: {
+                        pCircle = pCircle->m_pPrev;
+                        continue;
                     }
                     }
                     //ûУܸ¿ܲ
-                    pause.pause();
+                    if (!pause.bounded_pause()) {
+                        //the circle is full, claim the growing, or help the claim producer when it stall too long
+                        if (pCircle->IsNoWrite()) {
+                            Circle* pNextCircle = InstallNextCircle(pCircle, ++nGrowWait >= Traits::GrowHelpYieldTimes);
+                            if (pNextCircle != pCircle) {
+                                pCircle = pNextCircle;
+                                continue;
+                            }
+                        }
+                        pause.SwapThread();
+                    }
                     //ضҪжϣǷҪ
                     Circle* pNewCircle = m_pWrite;
                     if (pNewCircle != pCircle)
@@ -212,22 +625,82 @@ namespace cclockfree {
                     pCircle = pNewCircle;
                 }
             }
-            inline void PopMicroQueue(T& value, uint32_t nNowReadIndex) {
+            //! replace the unused head circle by a circle of nPerSize, nothing can push or pop at the same time
+            void ReserveMicroQueue(IndexType nIndex, uint8_t nLaneShift, uint32_t nPerSize) {
+                Circle* pHead = m_pHead;
+                m_pHead = Circle::CreateCircle(nPerSize, nIndex, nLaneShift);
+                Circle::ReleaseCircle(pHead);
+                atomic_thread_fence(std::memory_order_release);
+                m_pWrite = m_pHead;
+                m_pRead = m_pWrite;
+                m_pPrepareCircle = nullptr;
+            }
+            //! the first producer claim m_nGrowing alloc the next circle, the other return pCircle until it is install
+            //! bHelp alloc one even the growing is claim, by malloc only(no recycle lock), the first cas of m_pNext win
+            Circle* InstallNextCircle(Circle* pCircle, bool bHelp) {
+                Circle* pNextCircle = pCircle->m_pNext;
+                if (pNextCircle == nullptr) {
+                    bool bClaim = pCircle->m_nGrowing == 0 && CCLockfreeInterlockedCompareExchange(&pCircle->m_nGrowing, 0, 1);
+                    if (!bClaim && !bHelp)
+                        return pCircle;
+                    CircleRecycle* pRecycle = bClaim ? m_pRecycle : nullptr;
+                    Circle* pNewCircle = Circle::CreateNextCircle(pCircle, pRecycle);
+                    atomic_thread_fence(std::memory_order_release);
+                    if (CCLockfreeInterlockedCompareExchangePointer(&pCircle->m_pNext, (Circle*)nullptr, pNewCircle)) {
+                        pNextCircle = pNewCircle;
+                        CCLockfreeInterlockedIncrement(&m_nGrowCount);
+                    }
+                    else {
+                        Circle::DropCircle(pNewCircle, pRecycle);
+                        pNextCircle = pCircle->m_pNext;
+                    }
+                }
+                atomic_thread_fence(std::memory_order_acquire);
+                //m_pWrite may be already move forward, never move it back
+                CCLockfreeInterlockedCompareExchangePointer(&m_pWrite, pCircle, pNextCircle);
+                return pNextCircle;
+            }
+            //! alloc the pool of the next circle on the consumer side, once every write circle
+            //! it is put in the recycle cache, so the next circle of any lane can take it
+            void PrepareNextCircle(IndexType nReadIndex) {
+                Circle* pWriteCircle = m_pWrite;
+                Circle* pPrepareCircle = m_pPrepareCircle;
+                if (pWriteCircle == pPrepareCircle || pWriteCircle->m_pNext != nullptr)
+                    return;
+                IndexType nSize = *m_pPreWriteIndex - nReadIndex;
+                if ((uint64_t)nSize * 100 < (uint64_t)pWriteCircle->GetCheckTotalSizeValue() * Traits::PrepareCirclePercent)
+                    return;
+                if (!CCLockfreeInterlockedCompareExchangePointer(&m_pPrepareCircle, pPrepareCircle, pWriteCircle))
+                    return;
+                uint8_t nGrowTimes;
+                uint32_t nTotalSize = Circle::GetNextTotalSize(pWriteCircle, nGrowTimes);
+                if (StoreData::GetPoolSize(nTotalSize) > Traits::RecycleCacheMaxSize)
+                    return;
+                StoreData* pPool = (StoreData*)Traits::malloc(StoreData::GetPoolSize(nTotalSize));
+                if (!Traits::MallocZeroMemory)
+                    StoreData::ResetFlag(pPool, nTotalSize);
+                if (!m_pRecycle->PutPool(pPool, nTotalSize))
+                    Traits::free(pPool);
+            }
+            inline void PopMicroQueue(T& value, IndexType nNowReadIndex) {
                 atomic_backoff pause;
                 Circle* pReadCircle = m_pRead;
                 atomic_thread_fence(std::memory_order_acquire);
                 while (true) {
                     switch (pReadCircle->PopPosition(value, nNowReadIndex)) {
                     case 0: {
+                        if (Traits::PrepareCirclePercent && Traits::RecycleCacheCount && pReadCircle->IsPrepareCheckIndex(nNowReadIndex))
+                            PrepareNextCircle(nNowReadIndex);
                         return;
                     }
                     case 1: {
                         //need read next circle
-                        while (m_nReadCircle == m_nWriteCircle) {
+                        while (pReadCircle->m_pNext == nullptr) {
                             pause.pause();
                         }
-                        m_pRead = m_pCircle[++m_nReadCircle];
-                        pReadCircle->ReleasePool();
+                        atomic_thread_fence(std::memory_order_acquire);
+                        m_pRead = pReadCircle->m_pNext;
+                        pReadCircle->RecyclePool(m_pRecycle);
                         pReadCircle = m_pRead;
                         break;
                     }
@@ -246,86 +719,686 @@ namespace cclockfree {
             }
         };
     public:
-        CCLockfreeQueue() {
+        //! one producer thread only, buffer the push and push them by one index reservation
+        //! the buffer push to continuous index, every lane get a run of neighbouring slot and the producer FIFO is keep
+        //! the data is visible after Flush, it is called when the buffer is full and when the token destroy
+        class ProducerToken {
+        public:
+            ProducerToken(CCLockfreeQueue& queue) : m_queue(queue), m_nCount(0) {
+            }
+            ~ProducerToken() {
+                Flush();
+            }
+            //! false when the queue can not write the value(see CCLockfreeQueue::Push), it is not buffer
+            bool Push(const T& value) {
+                return Emplace(value);
+            }
+            bool Push(T&& value) {
+                return Emplace(std::move(value));
+            }
+            template<class... Args>
+            bool Emplace(Args&&... args) {
+                T* pData = new (&GetData()[m_nCount]) T(std::forward<Args>(args)...);
+                if (!CanWrite(CheckWrite(), *pData)) {
+                    pData->~T();
+                    return false;
+                }
+                if (++m_nCount == Traits::ProducerTokenSize)
+                    Flush();
+                return true;
+            }
+            void Flush() {
+                if (m_nCount == 0)
+                    return;
+                T* pData = GetData();
+                m_queue.PushBulk(std::make_move_iterator(pData), m_nCount);
+                for (uint32_t i = 0; i < m_nCount; i++) {
+                    pData[i].~T();
+                }
+                m_nCount = 0;
+            }
+            uint32_t GetBufferCount() {
+                return m_nCount;
+            }
+        protected:
+            inline T* GetData() {
+                return reinterpret_cast<T*>(&m_pData);
+            }
+        protected:
+            CCLockfreeQueue&                m_queue;
+            uint32_t                        m_nCount;
+            typename std::aligned_storage<sizeof(T) * Traits::ProducerTokenSize, alignof(T)>::type m_pData;
+        };
+    public:
+        //! nLaneCount round up to power(2), 0 use Traits::ThreadWriteIndexModeIndex
+        //! nCapacity 0 is unbounded, otherwise Push wait and TryPush fail when the size reach nCapacity
+        //! nReserve 0 start from Traits::BlockDefaultPerSize, otherwise see Reserve
+        CCLockfreeQueue(uint32_t nLaneCount = 0, IndexType nCapacity = 0, IndexType nReserve = 0) {
             static_assert((Traits::BlockDefaultPerSize & (Traits::BlockDefaultPerSize - 1)) == 0,
                 "Traits::BlockDefaultPerSize is not power(2) error!");
             static_assert((Traits::ThreadWriteIndexModeIndex & (Traits::ThreadWriteIndexModeIndex - 1)) == 0,
                 "Traits::ThreadWriteIndexModeIndex is not power(2) error!");
 
-            uint32_t nSetBeginIndex = Traits::CCLockfreeQueueStartIndex;
+            m_nCapacity = nCapacity;
+            if (nLaneCount == 0)
+                nLaneCount = GetDefaultLaneCount();
+            uint8_t nLaneShift = 0;
+            while ((1u << nLaneShift) < nLaneCount)
+                nLaneShift++;
+            nLaneCount = 1 << nLaneShift;
+            m_nLaneMask = nLaneCount - 1;
+            m_queue = (MicroQueue*)CCLockfreeAlignedMalloc<Traits>(sizeof(MicroQueue) * nLaneCount, alignof(MicroQueue));
+
+            IndexType nSetBeginIndex = Traits::CCLockfreeQueueStartIndex;
             m_nReadIndex = nSetBeginIndex;
             m_nPreWriteIndex = nSetBeginIndex;
+            m_nWriteIndex = nSetBeginIndex;
+            m_nCacheReadIndex = nSetBeginIndex;
+            m_nCacheWriteIndex = nSetBeginIndex;
+            m_pCommitRing = nullptr;
+            if (Traits::CommittedWrite) {
+                static_assert((Traits::CommitRingSize & (Traits::CommitRingSize - 1)) == 0,
+                    "Traits::CommitRingSize is not power(2) error!");
+                //the value is the commit of the last user(index - CommitRingSize)
+                const IndexType nMask = Traits::CommitRingSize - 1;
+                m_pCommitRing = (std::atomic<IndexType>*)CCLockfreeAlignedMalloc<Traits>(sizeof(std::atomic<IndexType>) * Traits::CommitRingSize, alignof(std::atomic<IndexType>));
+                for (uint32_t i = 0; i < Traits::CommitRingSize; i++) {
+                    IndexType nFirstIndex = nSetBeginIndex + ((i - nSetBeginIndex) & nMask);
+                    new (&m_pCommitRing[i]) std::atomic<IndexType>(nFirstIndex + 1 - Traits::CommitRingSize);
+                }
+            }
 #ifdef USE_QUICKPOP_CCLOCKFREEQUEUE
             m_nPreReadIndex = m_nReadIndex;
 #endif
-            for (uint8_t i = 0; i < Traits::ThreadWriteIndexModeIndex; i++) {
-                m_queue[i].InitMicroQueue(nSetBeginIndex + i);
+            m_nIdleReadIndex.store(m_nReadIndex, std::memory_order_relaxed);
+            m_nIdleBeginTime.store(GetIdleNow(), std::memory_order_relaxed);
+            for (uint32_t i = 0; i < nLaneCount; i++) {
+                new (&m_queue[i]) MicroQueue();
+                m_queue[i].InitMicroQueue(nSetBeginIndex + i, nLaneShift, &m_recycle, &m_nPreWriteIndex);
             }
+            if (nReserve)
+                Reserve(nReserve);
         }
         virtual ~CCLockfreeQueue() {
-
+            for (uint32_t i = 0; i <= m_nLaneMask; i++) {
+                m_queue[i].~MicroQueue();
+            }
+            CCLockfreeAlignedFree<Traits>(m_queue);
+            CCLockfreeAlignedFree<Traits>(m_pCommitRing);
         }
-        uint32_t GetSize() {
-            uint32_t nRead = m_nReadIndex;
-            uint32_t nWrite = m_nPreWriteIndex;
+        static uint32_t GetDefaultLaneCount() {
+            uint32_t nLaneCount = Traits::ThreadWriteIndexModeIndex;
+            if (nLaneCount == 0)
+                nLaneCount = std::thread::hardware_concurrency();
+            return nLaneCount == 0 ? 4 : nLaneCount;
+        }
+        uint32_t GetLaneCount() {
+            return m_nLaneMask + 1;
+        }
+        IndexType GetSize() {
+            IndexType nRead = m_nReadIndex;
+            IndexType nWrite = m_nPreWriteIndex;
             return nWrite - nRead;
         }
-        void Push(const T& value) {
-            uint32_t nPreWriteIndex = CCLockfreeInterlockedIncrement(&m_nPreWriteIndex);
-            m_queue[nPreWriteIndex % Traits::ThreadWriteIndexModeIndex].PushMicroQueue(value, nPreWriteIndex);
+        //! make the first circle of every lane big enough that a backlog of nReserve never grow a new circle
+        //! only before the first push and not thread safe, return false when the queue is used
+        bool Reserve(IndexType nReserve) {
+            const IndexType nStartIndex = Traits::CCLockfreeQueueStartIndex;
+            if (m_nPreWriteIndex != nStartIndex || m_nReadIndex != nStartIndex)
+                return false;
+            uint8_t nLaneShift = 0;
+            while ((1u << nLaneShift) <= m_nLaneMask)
+                nLaneShift++;
+            IndexType nLaneReserve = (nReserve + m_nLaneMask) >> nLaneShift;
+            //the circle turn over when the half before is pop, so the backlog is not more than nPerSize
+            const IndexType nMaxCheckTotalSizeValue = (IndexType)1 << (sizeof(IndexType) * 8 - 2);
+            uint32_t nPerSize = Traits::BlockDefaultPerSize;
+            uint8_t nGrowTimes = 0;
+            while (nPerSize < nLaneReserve && nGrowTimes < Traits::CirclePointNumber && nPerSize < 0x40000000 &&
+                ((IndexType)nPerSize << (nLaneShift + 2)) <= nMaxCheckTotalSizeValue) {
+                nPerSize *= 2;
+                nGrowTimes++;
+            }
+            if (nGrowTimes == 0)
+                return true;
+            for (uint32_t i = 0; i <= m_nLaneMask; i++) {
+                m_queue[i].ReserveMicroQueue(nStartIndex + i, nLaneShift, nPerSize);
+            }
+            return true;
+        }
+        //! the next circle install times of all the lane, no growth after a big enough Reserve
+        uint32_t GetGrowCount() {
+            uint32_t nGrowCount = 0;
+            for (uint32_t i = 0; i <= m_nLaneMask; i++) {
+                nGrowCount += m_queue[i].m_nGrowCount;
+            }
+            return nGrowCount;
+        }
+        //! give the cached pool back to system, thread safe
+        void ReleaseRecycleCache() {
+            m_recycle.ReleaseAll();
+        }
+        size_t GetRecycleCacheSize() {
+            return m_recycle.GetCacheSize();
+        }
+        IndexType GetCapacity() {
+            return m_nCapacity;
+        }
+        //! wait for space when the queue is bounded
+        //! Traits::PointerSlot pointer T return false for nullptr and the address under 0x100, nothing is push
+        bool Push(const T& value) {
+            return Emplace(value);
+        }
+        bool Push(T&& value) {
+            return Emplace(std::move(value));
+        }
+        //! return false when the bounded queue is full or the value can not write
+        bool TryPush(const T& value) {
+            return TryEmplace(value);
+        }
+        bool TryPush(T&& value) {
+            return TryEmplace(std::move(value));
+        }
+        //! construct T in the slot, args is not used when return false
+        template<class... Args>
+        bool Emplace(Args&&... args) {
+            return EmplaceCheck(CheckWrite(), false, std::forward<Args>(args)...);
+        }
+        template<class... Args>
+        bool TryEmplace(Args&&... args) {
+            return EmplaceCheck(CheckWrite(), true, std::forward<Args>(args)...);
+        }
+        //! reserve nCount continuous index by once, then fan out to the MicroQueue
+        //! the bounded queue reserve at most nCapacity once, so wait the space part by part
+        //! push nothing and return false when one value can not write, Iterator is read twice for Traits::PointerSlot
+        template<class Iterator>
+        bool PushBulk(Iterator first, uint32_t nCount) {
+            if (!CanWriteBulk(CheckWrite(), first, nCount))
+                return false;
+            while (nCount > 0) {
+                uint32_t nReserve = nCount;
+                if (m_nCapacity != 0 && nReserve > m_nCapacity)
+                    nReserve = (uint32_t)m_nCapacity;
+                IndexType nPreWriteIndex = ReserveWriteIndex(nReserve);
+                for (uint32_t i = 0; i < nReserve; i++, ++first) {
+                    IndexType nIndex = nPreWriteIndex + i;
+                    m_queue[nIndex & m_nLaneMask].PushMicroQueue(nIndex, *first);
+                }
+                nCount -= nReserve;
+                FinishWrite(nPreWriteIndex, nReserve);
+            }
+            return true;
+        }
+        //! push all or nothing, return false when the bounded queue has not enough space or one value can not write
+        template<class Iterator>
+        bool TryPushBulk(Iterator first, uint32_t nCount) {
+            if (nCount == 0)
+                return true;
+            if (!CanWriteBulk(CheckWrite(), first, nCount))
+                return false;
+            IndexType nPreWriteIndex;
+            if (!TryReserve(nCount, nPreWriteIndex))
+                return false;
+            for (uint32_t i = 0; i < nCount; i++, ++first) {
+                IndexType nIndex = nPreWriteIndex + i;
+                m_queue[nIndex & m_nLaneMask].PushMicroQueue(nIndex, *first);
+            }
+            FinishWrite(nPreWriteIndex, nCount);
+            return true;
+        }
+
+        //! spin Traits::WaitSpinCount times then park until push
+        void WaitPop(T& value) {
+            static_assert(Traits::QueueMode != CCLockfreeQueueMode_SPSC || Traits::SingleProducerWaitPop, "WaitPop need Traits::SingleProducerWaitPop");
+            m_eventCount.WaitFor([&]() { return Pop(value); }, Traits::WaitSpinCount, CCLockfreeEventCount::Infinite);
+        }
+        //! return false when nothing to pop after nMilliseconds
+        bool WaitPopFor(T& value, uint32_t nMilliseconds) {
+            static_assert(Traits::QueueMode != CCLockfreeQueueMode_SPSC || Traits::SingleProducerWaitPop, "WaitPop need Traits::SingleProducerWaitPop");
+            return m_eventCount.WaitFor([&]() { return Pop(value); }, Traits::WaitSpinCount, nMilliseconds);
         }
 
 #ifdef USE_QUICKPOP_CCLOCKFREEQUEUE
         bool Pop(T& value) {
+            if (SingleConsumer)
+                return PopSingle(value);
             //read after
-            uint32_t nPreReadIndex = CCLockfreeInterlockedIncrement(&m_nPreReadIndex);
-            uint32_t nPreWriteIndex = m_nPreWriteIndex;
-            if (uint32_t_after(nPreWriteIndex, nPreReadIndex)) {
-                uint32_t nRead = CCLockfreeInterlockedIncrement(&m_nReadIndex);
-                m_queue[nRead % Traits::ThreadWriteIndexModeIndex].PopMicroQueue(value, nRead);
+            IndexType nPreReadIndex = CCLockfreeInterlockedIncrement(&m_nPreReadIndex);
+            IndexType nPreWriteIndex = GetPublishIndex();
+            if (IndexAfter(nPreWriteIndex, nPreReadIndex)) {
+                IndexType nRead = CCLockfreeInterlockedIncrement(&m_nReadIndex);
+                m_queue[nRead & m_nLaneMask].PopMicroQueue(value, nRead);
                 return true;
             };
             //Queue is empty
             CCLockfreeInterlockedDecrementNoCheckReturn(&m_nPreReadIndex);
+            CheckIdle();
             return false;
         }
+        //! return the pop count, reserve nMaxCount and give back the part can not read
+        template<class Iterator>
+        uint32_t PopBulk(Iterator out, uint32_t nMaxCount) {
+            if (SingleConsumer)
+                return PopBulkSingle(out, nMaxCount);
+            if (nMaxCount == 0)
+                return 0;
+            IndexType nPreReadIndex = CCLockfreeInterlockedAdd(&m_nPreReadIndex, (IndexType)nMaxCount);
+            IndexType nPreWriteIndex = GetPublishIndex();
+            uint32_t nCount = 0;
+            if (IndexAfter(nPreWriteIndex, nPreReadIndex)) {
+                IndexType nCanRead = nPreWriteIndex - nPreReadIndex;
+                nCount = nCanRead > nMaxCount ? nMaxCount : (uint32_t)nCanRead;
+            }
+            if (nCount != nMaxCount)
+                CCLockfreeInterlockedAdd(&m_nPreReadIndex, (IndexType)nCount - (IndexType)nMaxCount);
+            if (nCount == 0) {
+                CheckIdle();
+                return 0;
+            }
+            IndexType nRead = CCLockfreeInterlockedAdd(&m_nReadIndex, (IndexType)nCount);
+            for (uint32_t i = 0; i < nCount; i++, ++out) {
+                IndexType nIndex = nRead + i;
+                m_queue[nIndex & m_nLaneMask].PopMicroQueue(*out, nIndex);
+            }
+            return nCount;
+        }
 #else
-        bool PopIndex(T& value, uint32_t& nReadindex) {
-            uint32_t nWriteIndex, nNowReadIndex;
+        bool PopIndex(T& value, IndexType& nReadindex) {
+            if (SingleConsumer) {
+                nReadindex = m_nReadIndex;
+                return PopSingle(value);
+            }
+            IndexType nWriteIndex, nNowReadIndex;
             do {
                 nNowReadIndex = m_nReadIndex;
-                nWriteIndex = m_nPreWriteIndex;
+                nWriteIndex = GetPublishIndex();
                 if (nNowReadIndex == nWriteIndex) {
+                    CheckIdle();
                     return false;
                 }
             } while (CCLockfreeInterlockedCompareExchange(&m_nReadIndex, nNowReadIndex, nNowReadIndex + 1) != nNowReadIndex);
 
-            m_queue[nNowReadIndex % Traits::ThreadWriteIndexModeIndex].PopMicroQueue(value, nNowReadIndex);
+            m_queue[nNowReadIndex & m_nLaneMask].PopMicroQueue(value, nNowReadIndex);
             nReadindex = nNowReadIndex;
             return true;
         }
         bool Pop(T& value) {
-            uint32_t nWriteIndex, nNowReadIndex;
+            if (SingleConsumer)
+                return PopSingle(value);
+            IndexType nWriteIndex, nNowReadIndex;
             do {
                 nNowReadIndex = m_nReadIndex;
-                nWriteIndex = m_nPreWriteIndex;
+                nWriteIndex = GetPublishIndex();
                 if (nNowReadIndex == nWriteIndex) {
+                    CheckIdle();
                     return false;
                 }
             } while (!CCLockfreeInterlockedCompareExchange(&m_nReadIndex, nNowReadIndex, nNowReadIndex + 1));
 
-            m_queue[nNowReadIndex % Traits::ThreadWriteIndexModeIndex].PopMicroQueue(value, nNowReadIndex);
+            m_queue[nNowReadIndex & m_nLaneMask].PopMicroQueue(value, nNowReadIndex);
             return true;
         }
+        template<class Iterator>
+        uint32_t PopBulk(Iterator out, uint32_t nMaxCount) {
+            if (SingleConsumer)
+                return PopBulkSingle(out, nMaxCount);
+            IndexType nWriteIndex, nNowReadIndex;
+            uint32_t nCount;
+            do {
+                nNowReadIndex = m_nReadIndex;
+                nWriteIndex = GetPublishIndex();
+                if (nNowReadIndex == nWriteIndex || nMaxCount == 0) {
+                    CheckIdle();
+                    return 0;
+                }
+                IndexType nCanRead = nWriteIndex - nNowReadIndex;
+                nCount = nCanRead > nMaxCount ? nMaxCount : (uint32_t)nCanRead;
+            } while (!CCLockfreeInterlockedCompareExchange(&m_nReadIndex, nNowReadIndex, nNowReadIndex + nCount));
+
+            for (uint32_t i = 0; i < nCount; i++, ++out) {
+                IndexType nIndex = nNowReadIndex + i;
+                m_queue[nIndex & m_nLaneMask].PopMicroQueue(*out, nIndex);
+            }
+            return nCount;
+        }
 #endif
+        //! CommittedWrite or SPSC only, never wait for the producer which is still pushing
+        bool TryPop(T& value) {
+            static_assert(Traits::CommittedWrite || Traits::QueueMode == CCLockfreeQueueMode_SPSC, "TryPop need Traits::CommittedWrite or SPSC mode");
+            return Pop(value);
+        }
+        //! pointer queue only, return nullptr when empty
+        template<class P = T>
+        typename std::enable_if<std::is_pointer<P>::value, P>::type Pop() {
+            P value;
+            return Pop(value) ? value : nullptr;
+        }
+    protected:
+        static const bool SingleProducer = Traits::QueueMode == CCLockfreeQueueMode_SPSC;
+        static const bool SingleConsumer = Traits::QueueMode != CCLockfreeQueueMode_MPMC;
+        static inline bool CanWrite(std::true_type, const T& value) {
+            return StoreData::CanWrite(value);
+        }
+        static inline bool CanWrite(std::false_type, const T&) {
+            return true;
+        }
+        template<class Iterator>
+        static inline bool CanWriteBulk(std::true_type, Iterator first, uint32_t nCount) {
+            for (uint32_t i = 0; i < nCount; i++, ++first) {
+                if (CCLockfreequeueUnLikely(!StoreData::CanWrite(*first)))
+                    return false;
+            }
+            return true;
+        }
+        template<class Iterator>
+        static inline bool CanWriteBulk(std::false_type, Iterator, uint32_t) {
+            return true;
+        }
+        //! the pointer slot construct the value first to check it, the other slot construct in place
+        template<class... Args>
+        inline bool EmplaceCheck(std::true_type, bool bTry, Args&&... args) {
+            T value(std::forward<Args>(args)...);
+            if (CCLockfreequeueUnLikely(!StoreData::CanWrite(value)))
+                return false;
+            return EmplaceCheck(std::false_type(), bTry, value);
+        }
+        template<class... Args>
+        inline bool EmplaceCheck(std::false_type, bool bTry, Args&&... args) {
+            IndexType nPreWriteIndex;
+            if (bTry) {
+                if (!TryReserve(1, nPreWriteIndex))
+                    return false;
+            }
+            else {
+                nPreWriteIndex = ReserveWriteIndex(1);
+            }
+            m_queue[nPreWriteIndex & m_nLaneMask].PushMicroQueue(nPreWriteIndex, std::forward<Args>(args)...);
+            FinishWrite(nPreWriteIndex, 1);
+            return true;
+        }
+        //! reserve nCount index, wait for the space when bounded
+        inline IndexType ReserveWriteIndex(IndexType nCount) {
+            if (SingleProducer) {
+                atomic_backoff bPause;
+                while (!TryReserveSingle(nCount)) {
+                    bPause.pause();
+                }
+                return m_nPreWriteIndex;
+            }
+            if (CCLockfreequeueLikely(m_nCapacity == 0))
+                return CCLockfreeInterlockedAdd(&m_nPreWriteIndex, nCount);
+            return ReserveWriteIndexWait(nCount);
+        }
+        inline bool TryReserve(IndexType nCount, IndexType& nPreWriteIndex) {
+            if (SingleProducer) {
+                nPreWriteIndex = m_nPreWriteIndex;
+                return TryReserveSingle(nCount);
+            }
+            if (CCLockfreequeueLikely(m_nCapacity == 0)) {
+                nPreWriteIndex = CCLockfreeInterlockedAdd(&m_nPreWriteIndex, nCount);
+                return true;
+            }
+            return TryReserveWriteIndex(nCount, nPreWriteIndex);
+        }
+        //! the data of [nIndex, nIndex + nCount) is written, publish it and wake the WaitPop
+        inline void FinishWrite(IndexType nIndex, IndexType nCount) {
+            if (SingleProducer) {
+                //publish after write, the consumer never see a index not write
+                atomic_thread_fence(std::memory_order_release);
+                m_nPreWriteIndex = nIndex + nCount;
+                if (Traits::SingleProducerWaitPop) {
+                    atomic_thread_fence(std::memory_order_seq_cst);
+                    m_eventCount.NotifyAfterBarrier(nCount > 1);
+                }
+                return;
+            }
+            if (Traits::CommittedWrite)
+                CommitWrite(nIndex, (uint32_t)nCount);
+            m_eventCount.NotifyAfterBarrier(nCount > 1);
+        }
+        //! SPSC producer, the read index is cache and only reload when it look full
+        inline bool TryReserveSingle(IndexType nCount) {
+            if (CCLockfreequeueLikely(m_nCapacity == 0))
+                return true;
+            IndexType nWrite = m_nPreWriteIndex;
+            if (nWrite - m_nCacheReadIndex + nCount <= m_nCapacity)
+                return true;
+            m_nCacheReadIndex = m_nReadIndex;
+            atomic_thread_fence(std::memory_order_acquire);
+            return nWrite - m_nCacheReadIndex + nCount <= m_nCapacity;
+        }
+        //! single consumer, the write index is cache and only reload when it look empty
+        inline bool PopSingle(T& value) {
+            IndexType nRead = m_nReadIndex;
+            if (nRead == m_nCacheWriteIndex) {
+                m_nCacheWriteIndex = GetPublishIndex();
+                atomic_thread_fence(std::memory_order_acquire);
+                if (nRead == m_nCacheWriteIndex) {
+                    CheckIdle();
+                    return false;
+                }
+            }
+            m_queue[nRead & m_nLaneMask].PopMicroQueue(value, nRead);
+            atomic_thread_fence(std::memory_order_release);
+            m_nReadIndex = nRead + 1;
+            return true;
+        }
+        template<class Iterator>
+        inline uint32_t PopBulkSingle(Iterator out, uint32_t nMaxCount) {
+            IndexType nRead = m_nReadIndex;
+            IndexType nCanRead = m_nCacheWriteIndex - nRead;
+            if (nCanRead < nMaxCount) {
+                m_nCacheWriteIndex = GetPublishIndex();
+                atomic_thread_fence(std::memory_order_acquire);
+                nCanRead = m_nCacheWriteIndex - nRead;
+            }
+            uint32_t nCount = nCanRead > nMaxCount ? nMaxCount : (uint32_t)nCanRead;
+            if (nCount == 0) {
+                CheckIdle();
+                return 0;
+            }
+            for (uint32_t i = 0; i < nCount; i++, ++out) {
+                IndexType nIndex = nRead + i;
+                m_queue[nIndex & m_nLaneMask].PopMicroQueue(*out, nIndex);
+            }
+            atomic_thread_fence(std::memory_order_release);
+            m_nReadIndex = nRead + nCount;
+            return nCount;
+        }
+        //! the consumer can claim the index before it
+        inline IndexType GetPublishIndex() {
+            if (Traits::CommittedWrite && !SingleProducer)
+                return m_nWriteIndex.load();
+            return m_nPreWriteIndex;
+        }
+        //! CommittedWrite only, mark [nIndex, nIndex + nCount) push finish, then move the commit index as far as possible
+        inline void CommitWrite(IndexType nIndex, uint32_t nCount) {
+            const IndexType nMask = Traits::CommitRingSize - 1;
+            for (uint32_t i = 0; i < nCount; i++) {
+                IndexType nCommit = nIndex + i;
+                //the last user of the ring slot must be pass
+                atomic_backoff bPause;
+                while (!IndexAfter(m_nWriteIndex.load(), nCommit - Traits::CommitRingSize)) {
+                    AdvanceWriteIndex();
+                    bPause.pause();
+                }
+                m_pCommitRing[nCommit & nMask].store(nCommit + 1);
+            }
+            AdvanceWriteIndex();
+        }
+        //! every producer help, the one commit the oldest index move it over the other finish one
+        inline void AdvanceWriteIndex() {
+            const IndexType nMask = Traits::CommitRingSize - 1;
+            IndexType nWrite = m_nWriteIndex.load();
+            while (m_pCommitRing[nWrite & nMask].load() == nWrite + 1) {
+                //fail means other producer move it, nWrite is update to the new one
+                if (m_nWriteIndex.compare_exchange_strong(nWrite, nWrite + 1))
+                    nWrite++;
+            }
+        }
+        //! bounded queue only, the size count the index reserve by the consumer
+        inline bool TryReserveWriteIndex(IndexType nCount, IndexType& nPreWriteIndex) {
+            IndexType nWrite;
+            do {
+                nWrite = m_nPreWriteIndex;
+                IndexType nRead = m_nReadIndex;
+                //the read after the write we get means the write is old, cas fail and retry
+                if (!IndexAfter(nRead, nWrite) && nWrite - nRead + nCount > m_nCapacity)
+                    return false;
+            } while (!CCLockfreeInterlockedCompareExchange(&m_nPreWriteIndex, nWrite, nWrite + nCount));
+            nPreWriteIndex = nWrite;
+            return true;
+        }
+        inline IndexType ReserveWriteIndexWait(IndexType nCount) {
+            IndexType nPreWriteIndex;
+            atomic_backoff bPause;
+            while (!TryReserveWriteIndex(nCount, nPreWriteIndex)) {
+                bPause.pause();
+            }
+            return nPreWriteIndex;
+        }
+        //! called when pop nothing, the cache is release after Traits::RecycleIdleMilliseconds without read progress
+        //! any consumer can call, the cas let only one of them restart the idle time or release
+        inline void CheckIdle() {
+            if (Traits::RecycleIdleMilliseconds == 0 || m_recycle.GetCount() == 0)
+                return;
+            IndexType nRead = m_nReadIndex;
+            int64_t nNow = GetIdleNow();
+            IndexType nIdleRead = m_nIdleReadIndex.load(std::memory_order_relaxed);
+            if (nRead != nIdleRead) {
+                if (m_nIdleReadIndex.compare_exchange_strong(nIdleRead, nRead, std::memory_order_relaxed))
+                    m_nIdleBeginTime.store(nNow, std::memory_order_relaxed);
+                return;
+            }
+            int64_t nBegin = m_nIdleBeginTime.load(std::memory_order_relaxed);
+            if (nNow - nBegin >= (int64_t)Traits::RecycleIdleMilliseconds &&
+                m_nIdleBeginTime.compare_exchange_strong(nBegin, nNow, std::memory_order_relaxed)) {
+                m_recycle.ReleaseAll();
+            }
+        }
+        static inline int64_t GetIdleNow() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
     protected:
-        volatile uint32_t                                           m_nPreWriteIndex;
+        //read only after construct
+        MicroQueue*                                                 m_queue;
+        uint32_t                                                    m_nLaneMask;
+        IndexType                                                   m_nCapacity;
+        std::atomic<IndexType>*                                     m_pCommitRing;
+        //producer
+        CCLockfreeAlignAs(Traits, IndexType) volatile IndexType     m_nPreWriteIndex;
+        //SPSC producer only
+        IndexType                                                   m_nCacheReadIndex;
+        //CommittedWrite only, all the index before it is push finish
+        CCLockfreeAlignAs(Traits, IndexType) std::atomic<IndexType> m_nWriteIndex;
+        //consumer
 #ifdef USE_QUICKPOP_CCLOCKFREEQUEUE
-        volatile uint32_t                                           m_nPreReadIndex;
+        CCLockfreeAlignAs(Traits, IndexType) volatile IndexType     m_nPreReadIndex;
+        volatile IndexType                                          m_nReadIndex;
+#else
+        CCLockfreeAlignAs(Traits, IndexType) volatile IndexType     m_nReadIndex;
 #endif
-        volatile uint32_t                                           m_nReadIndex;
+        //single consumer only
+        IndexType                                                   m_nCacheWriteIndex;
+        //idle check, only touch when pop nothing, the read index and the steady clock milliseconds of the last read progress
+        std::atomic<IndexType>                                      m_nIdleReadIndex;
+        std::atomic<int64_t>                                        m_nIdleBeginTime;
+        //drained pool cache
+        CCLockfreeAlignAs(Traits, CircleRecycle) CircleRecycle      m_recycle;
+        //WaitPop park here
+        CCLockfreeAlignAs(Traits, CCLockfreeEventCount) CCLockfreeEventCount m_eventCount;
+    };
 
-        MicroQueue                                                  m_queue[Traits::ThreadWriteIndexModeIndex];
+    //! one CCLockfreeQueue every numa node, the queue and its circle pool stay on the node
+    //! the producer push to the queue of its node(CCLockfreeNumaCurrentNode), pin the producer before the first push
+    //! the consumer drain the node queue by turn, the FIFO of every producer is keep, no FIFO between the producer
+    //! the single node machine has one queue, the same as CCLockfreeQueue
+    template<class T, class Traits = CCLockfreeQueuePageFunc, class ObjectBaseClass = CCLockfreeObject<Traits>>
+    class CCLockfreeNumaQueue : public ObjectBaseClass {
+    public:
+        typedef CCLockfreeQueue<T, Traits> NodeQueue;
+        typedef typename NodeQueue::IndexType IndexType;
+        //! nLaneCount and nReserve is for every node queue, see CCLockfreeQueue
+        //! nNodeCount 0 use CCLockfreeNumaNodeCount()
+        CCLockfreeNumaQueue(uint32_t nLaneCount = 0, IndexType nReserve = 0, uint32_t nNodeCount = 0) {
+            if (nNodeCount == 0)
+                nNodeCount = CCLockfreeNumaNodeCount();
+            m_nNodeCount = nNodeCount;
+            m_nPopNode = 0;
+            m_pQueue = new NodeQueue*[nNodeCount];
+            if (nNodeCount == 1) {
+                m_pQueue[0] = new NodeQueue(nLaneCount, 0, nReserve);
+                return;
+            }
+            for (uint32_t i = 0; i < nNodeCount; i++) {
+                //first touch the queue and the first circle on the node
+                std::thread([this, i, nLaneCount, nReserve]() {
+                    CCLockfreeNumaRunOnNode(i);
+                    m_pQueue[i] = new NodeQueue(nLaneCount, 0, nReserve);
+                }).join();
+            }
+        }
+        virtual ~CCLockfreeNumaQueue() {
+            for (uint32_t i = 0; i < m_nNodeCount; i++) {
+                delete m_pQueue[i];
+            }
+            delete[]m_pQueue;
+        }
+        uint32_t GetNodeCount() {
+            return m_nNodeCount;
+        }
+        NodeQueue& GetNodeQueue(uint32_t nNode) {
+            return *m_pQueue[nNode];
+        }
+        IndexType GetSize() {
+            IndexType nSize = 0;
+            for (uint32_t i = 0; i < m_nNodeCount; i++) {
+                nSize += m_pQueue[i]->GetSize();
+            }
+            return nSize;
+        }
+        bool Push(const T& value) {
+            return Emplace(value);
+        }
+        bool Push(T&& value) {
+            return Emplace(std::move(value));
+        }
+        template<class... Args>
+        bool Emplace(Args&&... args) {
+            return GetLocalQueue().Emplace(std::forward<Args>(args)...);
+        }
+        template<class Iterator>
+        bool PushBulk(Iterator first, uint32_t nCount) {
+            return GetLocalQueue().PushBulk(first, nCount);
+        }
+        //! pop the node queue by turn, start from the node after the last pop
+        bool Pop(T& value) {
+            uint32_t nBegin = m_nPopNode;
+            for (uint32_t i = 0; i < m_nNodeCount; i++) {
+                uint32_t nNode = (nBegin + i) % m_nNodeCount;
+                if (m_pQueue[nNode]->Pop(value)) {
+                    m_nPopNode = nNode + 1;
+                    return true;
+                }
+            }
+            return false;
+        }
+        //! pointer queue only, return nullptr when empty
+        template<class P = T>
+        typename std::enable_if<std::is_pointer<P>::value, P>::type Pop() {
+            P value;
+            return Pop(value) ? value : nullptr;
+        }
+    protected:
+        inline NodeQueue& GetLocalQueue() {
+            return *m_pQueue[CCLockfreeNumaCurrentNode() % m_nNodeCount];
+        }
+    protected:
+        //read only after construct
+        NodeQueue**                                                 m_pQueue;
+        uint32_t                                                    m_nNodeCount;
+        //consumer, the node to pop first
+        CCLockfreeAlignAs(Traits, uint32_t) volatile uint32_t       m_nPopNode;
     };
 }
 
@@ -32,4 +32,6 @@ typedef unsigned long DWORD;
 #define POW2SIZE    2097152
 #endif
 
+#define BULK_SIZE   64
+
 
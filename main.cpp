@@ -41,6 +41,45 @@ struct ctx_message {
     }
 };
 
+//! 6 bytes message for the packed slot, thread index 8 bit and number 24 bit, send/receive count wrap at 256
+struct ctx_message_small {
+    uint8_t         m_nIndex;
+    uint8_t         m_nCtxID[3];
+    uint8_t         m_nReceived;
+    uint8_t         m_nSend;
+    ctx_message_small() {
+        memset(this, 0, sizeof(ctx_message_small));
+    }
+
+    void InitUint(uint32_t nIndex, uint32_t nValue) {
+        m_nIndex = (uint8_t)nIndex;
+        m_nCtxID[0] = (uint8_t)nValue;
+        m_nCtxID[1] = (uint8_t)(nValue >> 8);
+        m_nCtxID[2] = (uint8_t)(nValue >> 16);
+    }
+    uint32_t GetCheckIndex() {
+        return m_nIndex;
+    }
+    uint32_t GetCheckReceiveNumber() {
+        return m_nCtxID[0] | (m_nCtxID[1] << 8) | (m_nCtxID[2] << 16);
+    }
+    void Send() {
+        m_nSend++;
+    }
+    void Received() {
+        m_nReceived++;
+    }
+    bool IsSendReceiveSame() {
+        return m_nReceived == m_nSend && m_nSend != 0;
+    }
+};
+
+//! ctx_message with padding, check the slot layout with different payload size
+template<uint32_t nPayloadSize>
+struct ctx_message_payload : public ctx_message {
+    char            m_payload[nPayloadSize - sizeof(ctx_message)];
+};
+
 
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -57,28 +96,371 @@ CLockFreeMessageQueuePushPop conMsgQueue;
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//! nPopThread 0 pop with the same thread count as push
 template<class msg, class Queue>
-bool BenchmarkQueue(Queue& q, int nRepeatTimes, int nMinThread, int nMaxThread) {
+bool BenchmarkQueue(Queue& q, int nRepeatTimes, int nMinThread, int nMaxThread, uint32_t nPopThread = 0) {
     bool bRet = true;
     auto pCBasicQueueArrayMode = new CContainUnitThreadRunMode<msg, Queue>(&q, TIMES_FAST, nRepeatTimes);
-    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(PushContentFunc<msg, Queue>, PopContentFunc<ctx_message, Queue>, nMaxThread, nMinThread);
+    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(PushContentFunc<msg, Queue>, PopContentFunc<msg, Queue>, nMaxThread, nMinThread, nPopThread);
     delete pCBasicQueueArrayMode;
     if (bRet == false)
         return bRet;
     return bRet;
 }
 
+//! push the pointer of the node, the queue is Queue<msg*>
+template<class msg, class Queue>
+bool BenchmarkQueuePointer(Queue& q, int nRepeatTimes, int nMinThread, int nMaxThread) {
+    bool bRet = true;
+    auto pCBasicQueueArrayMode = new CContainUnitThreadRunMode<msg, Queue>(&q, TIMES_FAST, nRepeatTimes);
+    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(PushFunc<msg, Queue>, PopFunc<msg, Queue>, nMaxThread, nMinThread);
+    delete pCBasicQueueArrayMode;
+    return bRet;
+}
+
+template<class msg, class Queue>
+bool BenchmarkQueueBulk(Queue& q, int nRepeatTimes, int nMinThread, int nMaxThread, uint32_t nPopThread = 0) {
+    bool bRet = true;
+    auto pCBasicQueueArrayMode = new CContainUnitThreadRunMode<msg, Queue>(&q, TIMES_FAST, nRepeatTimes);
+    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(PushBulkContentFunc<msg, Queue>, PopBulkContentFunc<msg, Queue>, nMaxThread, nMinThread, nPopThread);
+    delete pCBasicQueueArrayMode;
+    return bRet;
+}
+
+template<class msg, class Queue>
+bool BenchmarkQueueToken(Queue& q, int nRepeatTimes, int nMinThread, int nMaxThread) {
+    bool bRet = true;
+    auto pCBasicQueueArrayMode = new CContainUnitThreadRunMode<msg, Queue>(&q, TIMES_FAST, nRepeatTimes);
+    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(PushTokenContentFunc<msg, Queue>, PopContentFunc<msg, Queue>, nMaxThread, nMinThread);
+    delete pCBasicQueueArrayMode;
+    return bRet;
+}
+
 template<class msg, class Queue>
-bool BenchmarkQueueTime(Queue& q, int nTotalTimes, int nPushThread, int nPopThread) {
+bool BenchmarkQueueTime(Queue& q, int nTotalTimes, int nPushThread, int nPopThread, CCLOCKFREEQUEUE_THREAD_START_ROUTINE lpStartAddressPop = PopContentNoNullFunc<msg, Queue>) {
     bool bRet = true;
     auto pCBasicQueueArrayMode = new CContainUnitThreadRunModeTime<msg, Queue>(&q, TIMES_FAST, nTotalTimes);
-    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(nPushThread, nPopThread);
+    bRet &= pCBasicQueueArrayMode->PowerOfTwoThreadCountTest(nPushThread, nPopThread, lpStartAddressPop);
     delete pCBasicQueueArrayMode;
     if (bRet == false)
         return bRet;
     return bRet;
 }
 
+//! lossy ring, nPushThread push without wait and one reader pop at the same time, print the pop and drop count
+//! every push thread must be pop by order, a torn slot break the order
+//! a ring not smaller than the push count never drop, every push accepted must be pop or drop
+template<class msg, class Queue>
+bool BenchmarkOverwriteQueue(Queue& q, uint32_t nPushThread, uint32_t nPushTimes) {
+    bool bRet = true;
+    std::atomic<uint32_t> nFinishThread(0);
+    std::atomic<uint32_t> nRefuse(0);
+    uint32_t nPopCount = 0;
+    uint32_t* pLastNumber = new uint32_t[nPushThread];
+    memset(pLastNumber, 0, sizeof(uint32_t) * nPushThread);
+    char szBuf[64];
+    ccsnprintf(szBuf, 64, "PushThreadCount(%d) Overwrite", nPushThread);
+    CreateCalcUseTime(begin, PrintLockfreeUseTime(szBuf, nPushThread * nPushTimes), false);
+    StartCalcUseTime(begin);
+    std::thread* pPushThread = new std::thread[nPushThread];
+    for (uint32_t j = 0; j < nPushThread; j++) {
+        pPushThread[j] = std::thread([&q, &nFinishThread, &nRefuse, j, nPushTimes]() {
+            msg node;
+            for (uint32_t i = 1; i <= nPushTimes; i++) {
+                node.InitUint(j, i);
+                if (!q.Push(node))
+                    nRefuse++;
+            }
+            nFinishThread++;
+        });
+    }
+    auto popFunc = [&]() {
+        msg node;
+        if (!q.Pop(node))
+            return false;
+        uint32_t nIndex = node.GetCheckIndex();
+        uint32_t nNumber = node.GetCheckReceiveNumber();
+        if (nIndex >= nPushThread || nNumber <= pLastNumber[nIndex] || nNumber > nPushTimes)
+            bRet = false;
+        else
+            pLastNumber[nIndex] = nNumber;
+        nPopCount++;
+        return true;
+    };
+    while (nFinishThread < nPushThread) {
+        if (!popFunc())
+            std::this_thread::yield();
+    }
+    while (popFunc()) {
+    }
+    for (uint32_t j = 0; j < nPushThread; j++) {
+        pPushThread[j].join();
+    }
+    EndCalcUseTimeCallback(begin, nullptr);
+    CallbackUseTime(begin);
+    uint32_t nPushCount = nPushThread * nPushTimes;
+    uint32_t nDropCount = q.GetDropCount();
+    printf("Push:%d Pop:%d Drop:%d Refuse:%d\n", nPushCount, nPopCount, nDropCount, (uint32_t)nRefuse);
+    if (nPopCount + nDropCount > nPushCount)
+        bRet = false;
+    if (nPushCount <= q.GetCapacity() && (nDropCount != 0 || nRefuse != 0))
+        bRet = false;
+    if (nRefuse == 0 && nPopCount + nDropCount != nPushCount)
+        bRet = false;
+    if (!bRet)
+        printf("check fail!\n");
+    delete[]pPushThread;
+    delete[]pLastNumber;
+    return bRet;
+}
+
+//! one push thread feed nConsumer pop thread, every pop thread must receive all by order
+//! BroadcastQueue push once for all, Queue is one queue every consumer and push nConsumer times
+template<class msg, class BroadcastQueue, class Queue>
+bool BenchmarkBroadcastQueue(uint32_t nConsumer, uint32_t nSize, uint32_t nPushTimes) {
+    bool bRet = true;
+    std::atomic<bool> bCheck(true);
+    std::thread* pPopThread = new std::thread[nConsumer];
+    char szBuf[2][64];
+    ccsnprintf(szBuf[0], 64, "ConsumerCount(%d) Broadcast", nConsumer);
+    CreateCalcUseTime(beginBroadcast, PrintLockfreeUseTime(szBuf[0], nPushTimes), false);
+    ccsnprintf(szBuf[1], 64, "ConsumerCount(%d) QueueEveryConsumer", nConsumer);
+    CreateCalcUseTime(beginQueue, PrintLockfreeUseTime(szBuf[1], nPushTimes), false);
+    {
+        BroadcastQueue broadcastQueue(nConsumer, nSize);
+        StartCalcUseTime(beginBroadcast);
+        for (uint32_t j = 0; j < nConsumer; j++) {
+            pPopThread[j] = std::thread([&broadcastQueue, &bCheck, j, nPushTimes]() {
+                msg node;
+                for (uint32_t i = 1; i <= nPushTimes; i++) {
+                    while (!broadcastQueue.Pop(j, node))
+                        std::this_thread::yield();
+                    if (node.GetCheckReceiveNumber() != i)
+                        bCheck = false;
+                }
+            });
+        }
+        msg node;
+        for (uint32_t i = 1; i <= nPushTimes; i++) {
+            node.InitUint(0, i);
+            while (!broadcastQueue.Push(node))
+                std::this_thread::yield();
+        }
+        for (uint32_t j = 0; j < nConsumer; j++) {
+            pPopThread[j].join();
+        }
+        EndCalcUseTimeCallback(beginBroadcast, nullptr);
+    }
+    {
+        Queue** pQueue = new Queue*[nConsumer];
+        for (uint32_t j = 0; j < nConsumer; j++) {
+            pQueue[j] = new Queue(nSize);
+        }
+        StartCalcUseTime(beginQueue);
+        for (uint32_t j = 0; j < nConsumer; j++) {
+            pPopThread[j] = std::thread([pQueue, &bCheck, j, nPushTimes]() {
+                msg node;
+                for (uint32_t i = 1; i <= nPushTimes; i++) {
+                    while (!pQueue[j]->Pop(node))
+                        std::this_thread::yield();
+                    if (node.GetCheckReceiveNumber() != i)
+                        bCheck = false;
+                }
+            });
+        }
+        msg node;
+        for (uint32_t i = 1; i <= nPushTimes; i++) {
+            node.InitUint(0, i);
+            for (uint32_t j = 0; j < nConsumer; j++) {
+                while (!pQueue[j]->Push(node))
+                    std::this_thread::yield();
+            }
+        }
+        for (uint32_t j = 0; j < nConsumer; j++) {
+            pPopThread[j].join();
+            delete pQueue[j];
+        }
+        EndCalcUseTimeCallback(beginQueue, nullptr);
+        delete[]pQueue;
+    }
+    CallbackUseTime(beginBroadcast);
+    CallbackUseTime(beginQueue);
+    delete[]pPopThread;
+    bRet = bCheck;
+    if (!bRet)
+        printf("check fail!\n");
+    return bRet;
+}
+
+//! the queue is new and pop on nQueueNode, every node run nPushThreadPerNode producer
+//! CCLockfreeNumaQueue keep a queue on every node, the producer push to its node and only the consumer cross the node
+//! the single node machine run all the thread without pin
+template<class msg, class Queue>
+bool BenchmarkNumaQueue(uint32_t nQueueNode, uint32_t nPushThreadPerNode, uint32_t nPushTimes) {
+    uint32_t nNodeCount = cclockfree::CCLockfreeNumaNodeCount();
+    if (nQueueNode >= nNodeCount)
+        nQueueNode = 0;
+    uint32_t nPushThread = nNodeCount * nPushThreadPerNode;
+    bool bRet = true;
+    Queue* pQueue = nullptr;
+    //the lane is first touch on the queue node
+    std::thread([&pQueue, nQueueNode]() {
+        cclockfree::CCLockfreeNumaRunOnNode(nQueueNode);
+        pQueue = new Queue();
+    }).join();
+    uint32_t* pLastNumber = new uint32_t[nPushThread];
+    memset(pLastNumber, 0, sizeof(uint32_t) * nPushThread);
+    char szBuf[64];
+    ccsnprintf(szBuf, 64, "NodeCount(%d) PushThreadCount(%d)", nNodeCount, nPushThread);
+    CreateCalcUseTime(begin, PrintLockfreeUseTime(szBuf, nPushThread * nPushTimes), false);
+    StartCalcUseTime(begin);
+    std::thread* pPushThread = new std::thread[nPushThread];
+    for (uint32_t j = 0; j < nPushThread; j++) {
+        pPushThread[j] = std::thread([pQueue, j, nNodeCount, nPushTimes]() {
+            if (nNodeCount > 1)
+                cclockfree::CCLockfreeNumaRunOnNode(j % nNodeCount);
+            msg node;
+            for (uint32_t i = 1; i <= nPushTimes; i++) {
+                node.InitUint(j, i);
+                pQueue->Push(node);
+            }
+        });
+    }
+    std::thread popThread([&]() {
+        if (nNodeCount > 1)
+            cclockfree::CCLockfreeNumaRunOnNode(nQueueNode);
+        msg node;
+        for (uint32_t nPopCount = 0; nPopCount < nPushThread * nPushTimes;) {
+            if (!pQueue->Pop(node)) {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t nIndex = node.GetCheckIndex();
+            uint32_t nNumber = node.GetCheckReceiveNumber();
+            if (nIndex >= nPushThread || nNumber != pLastNumber[nIndex] + 1)
+                bRet = false;
+            else
+                pLastNumber[nIndex] = nNumber;
+            nPopCount++;
+        }
+    });
+    for (uint32_t j = 0; j < nPushThread; j++) {
+        pPushThread[j].join();
+    }
+    popThread.join();
+    EndCalcUseTimeCallback(begin, nullptr);
+    CallbackUseTime(begin);
+    delete[]pPushThread;
+    delete[]pLastNumber;
+    delete pQueue;
+    if (!bRet)
+        printf("check fail!\n");
+    return bRet;
+}
+
+//! the same payload through the array and the split slot layout of CCLockfreeFixQueue
+template<class msg>
+bool BenchmarkFixQueueLayout(int nRepeatTimes, int nMinThread, int nMaxThread) {
+    typedef cclockfree::CCLockfreeFixQueue<msg, POW2SIZE> ArrayFixQueue;
+    typedef cclockfree::CCLockfreeFixQueue<msg, POW2SIZE, cclockfree::CCLockfreeSplitFunc> SplitFixQueue;
+    bool bRet = true;
+    ArrayFixQueue* pArrayQueue = new ArrayFixQueue();
+    printf("CCLockfreeFixQueue array payload(%d) slot(%d)\n", (int)sizeof(msg), (int)sizeof(typename ArrayFixQueue::StoreLockfreeFixQueue));
+    bRet &= BenchmarkQueue<msg, ArrayFixQueue>(*pArrayQueue, nRepeatTimes, nMinThread, nMaxThread);
+    delete pArrayQueue;
+    SplitFixQueue* pSplitQueue = new SplitFixQueue();
+    printf("CCLockfreeFixQueue split payload(%d) slot(%d)\n", (int)sizeof(msg), (int)sizeof(msg) + 1);
+    bRet &= BenchmarkQueue<msg, SplitFixQueue>(*pSplitQueue, nRepeatTimes, nMinThread, nMaxThread);
+    delete pSplitQueue;
+    if (!bRet)
+        printf("check fail!\n");
+    return bRet;
+}
+
+//! push nTotalOperation through the queue, check every producer FIFO on every consumer
+template<class msg, class Queue>
+bool BenchmarkQueueSoak(Queue& q, uint64_t nTotalOperation, uint32_t nPushThread, uint32_t nPopThread) {
+    std::atomic<uint64_t> nPushTimes(0);
+    std::atomic<uint64_t> nPopTimes(0);
+    std::atomic<uint32_t> nPushFinish(0);
+    std::atomic<bool> bFail(false);
+    uint64_t nPerThread = nTotalOperation / nPushThread;
+    std::thread* pPushThread = new std::thread[nPushThread];
+    std::thread* pPopThread = new std::thread[nPopThread];
+    for (uint32_t j = 0; j < nPushThread; j++) {
+        pPushThread[j] = std::thread([&, j]() {
+            msg node;
+            for (uint64_t k = 0; k < nPerThread; k++) {
+                node.InitUint(j, (uint32_t)k);
+                q.Push(node);
+                if ((k & 0xFFFF) == 0xFFFF) {
+                    nPushTimes.fetch_add(0x10000, std::memory_order_relaxed);
+                    while (q.GetSize() > 1024 * 1024 * 10)
+                        CCSleep(1);
+                }
+            }
+            nPushTimes.fetch_add(nPerThread & 0xFFFF, std::memory_order_relaxed);
+            nPushFinish.fetch_add(1);
+        });
+    }
+    for (uint32_t j = 0; j < nPopThread; j++) {
+        pPopThread[j] = std::thread([&]() {
+            uint32_t* pLast = new uint32_t[nPushThread];
+            bool* pHasLast = new bool[nPushThread];
+            memset(pHasLast, 0, sizeof(bool) * nPushThread);
+            msg node;
+            uint64_t nPop = 0;
+            while (true) {
+                bool bPushFinish = nPushFinish.load() == nPushThread;
+                if (!q.Pop(node)) {
+                    if (bPushFinish && q.GetSize() == 0)
+                        break;
+                    continue;
+                }
+                uint32_t nThread = node.GetCheckIndex();
+                uint32_t nValue = node.GetCheckReceiveNumber();
+                if (nThread >= nPushThread || (pHasLast[nThread] && (int32_t)(nValue - pLast[nThread]) <= 0)) {
+                    bFail = true;
+                }
+                else {
+                    pLast[nThread] = nValue;
+                    pHasLast[nThread] = true;
+                }
+                if ((++nPop & 0xFFFF) == 0) {
+                    nPopTimes.fetch_add(0x10000, std::memory_order_relaxed);
+                }
+            }
+            nPopTimes.fetch_add(nPop & 0xFFFF, std::memory_order_relaxed);
+            delete[]pLast;
+            delete[]pHasLast;
+        });
+    }
+    CreateCalcUseTime(begin, nullptr, true);
+    uint32_t nCheckTime = 1000;
+    while (nPushFinish.load() != nPushThread) {
+        if (!IsTimeEnoughUseTime(begin, nCheckTime, nullptr)) {
+            CCSleep(1);
+            continue;
+        }
+        uint64_t nPush = nPushTimes.load(std::memory_order_relaxed);
+        uint64_t nPop = nPopTimes.load(std::memory_order_relaxed);
+        printf("Soak Push: %llu(%.3f/ms) Pop: %llu(%.3f/ms) Size: %llu\n", (unsigned long long)nPush, (double)nPush / nCheckTime,
+            (unsigned long long)nPop, (double)nPop / nCheckTime, (unsigned long long)q.GetSize());
+        nCheckTime += 1000;
+    }
+    for (uint32_t j = 0; j < nPushThread; j++) {
+        pPushThread[j].join();
+    }
+    for (uint32_t j = 0; j < nPopThread; j++) {
+        pPopThread[j].join();
+    }
+    delete[]pPushThread;
+    delete[]pPopThread;
+    bool bRet = !bFail && nPopTimes.load() == nPerThread * nPushThread;
+    printf("Soak finish Push: %llu Pop: %llu %s\n", (unsigned long long)nPushTimes.load(), (unsigned long long)nPopTimes.load(), bRet ? "success" : "fail");
+    return bRet;
+}
+
 int main(int argc, char* argv[]){
     int nTimes = 3;
     int nRepeatTimes = 5;
@@ -87,7 +469,16 @@ int main(int argc, char* argv[]){
     //Ĭ1
     int nHeavyTestTime = 10 * 1000;
     if (argc >= 2) {
-        argv[1];
+        //lockfreequeue soak [operation count], default push a little more than 2^32
+        if (strcmp(argv[1], "soak") == 0) {
+            uint64_t nSoakTimes = argc >= 3 ? strtoull(argv[2], nullptr, 10) : 0x100000000ULL + 0x100000;
+            cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueue64Func> soakQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue 64bit index soak(%llu)\n", (unsigned long long)nSoakTimes);
+            bool bRet = BenchmarkQueueSoak<ctx_message>(soakQueue, nSoakTimes, nMinThread, nMinThread);
+            printf("/*************************************************************************/\n");
+            return bRet ? 0 : 1;
+        }
     }
     if (nTimes <= 0 || nTimes > 100)
         nTimes = 3;
@@ -112,12 +503,171 @@ int main(int argc, char* argv[]){
                 }
             }
             printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue bulk(%d)\n", BULK_SIZE);
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueueBulk<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>(basicQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue token(%d)\n", cclockfree::CCLockfreeQueueFunc::ProducerTokenSize);
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueueToken<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>(basicQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
             printf("Start CCLockfreeQueue heavy\n");
-            if (!BenchmarkQueueTime<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>(basicQueue, nHeavyTestTime, nMinThread - 1 == 0 ? 1 : nMinThread - 1, nMinThread)) {
+            //bounded, the producer wait in Push when the consumer is slow
+            cclockfree::CCLockfreeQueue<ctx_message> heavyQueue(0, 1024 * 1024 * 10);
+            if (!BenchmarkQueueTime<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>(heavyQueue, nHeavyTestTime, nMinThread - 1 == 0 ? 1 : nMinThread - 1, nMinThread)) {
+                printf("check fail!\n");
+            }
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue heavy WaitPop\n");
+            if (!BenchmarkQueueTime<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>(heavyQueue, nHeavyTestTime, nMinThread - 1 == 0 ? 1 : nMinThread - 1, nMinThread, PopContentWaitNoNullFunc<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>)) {
+                printf("check fail!\n");
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueueCommittedFunc> CommittedQueue;
+            CommittedQueue committedQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue committed write\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, CommittedQueue>(committedQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> MallocQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueuePrepareFunc> PrepareQueue;
+            MallocQueue mallocQueue;
+            PrepareQueue prepareQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue next circle malloc/prepare heavy\n");
+            printf("CCLockfreeQueue malloc\n");
+            if (!BenchmarkQueueTime<ctx_message, MallocQueue>(mallocQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("CCLockfreeQueue prepare\n");
+            if (!BenchmarkQueueTime<ctx_message, PrepareQueue>(prepareQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> GrowQueue;
+            //bounded by the heavy throttle size, the reserve queue hold all the backlog in the first circle
+            GrowQueue growQueue(0, 1024 * 1024 * 10);
+            GrowQueue reserveQueue(0, 1024 * 1024 * 10, 1024 * 1024 * 10);
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue grow/reserve heavy\n");
+            printf("CCLockfreeQueue grow\n");
+            if (!BenchmarkQueueTime<ctx_message, GrowQueue>(growQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("GrowCount(%u)\n", growQueue.GetGrowCount());
+            printf("CCLockfreeQueue reserve\n");
+            if (!BenchmarkQueueTime<ctx_message, GrowQueue>(reserveQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("GrowCount(%u)\n", reserveQueue.GetGrowCount());
+            if (reserveQueue.GetGrowCount() != 0) {
+                printf("check fail!\n");
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> MallocQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueuePageFunc> PageQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueueHugePageFunc> HugePageQueue;
+            MallocQueue mallocQueue;
+            PageQueue pageQueue;
+            HugePageQueue hugePageQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue malloc/page/huge page heavy\n");
+            printf("CCLockfreeQueue malloc\n");
+            if (!BenchmarkQueueTime<ctx_message, MallocQueue>(mallocQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("CCLockfreeQueue page\n");
+            if (!BenchmarkQueueTime<ctx_message, PageQueue>(pageQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("CCLockfreeQueue huge page\n");
+            if (!BenchmarkQueueTime<ctx_message, HugePageQueue>(hugePageQueue, nHeavyTestTime, nMinThread, 1)) {
+                printf("check fail!\n");
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> MPMCQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueueSPSCFunc> SPSCQueue;
+            MPMCQueue mpmcQueue;
+            SPSCQueue spscQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue one producer one consumer\n");
+            printf("CCLockfreeQueue MPMC\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, MPMCQueue>(mpmcQueue, nRepeatTimes, 1, 1)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeQueue SPSC\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, SPSCQueue>(spscQueue, nRepeatTimes, 1, 1)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeQueue MPMC heavy\n");
+            if (!BenchmarkQueueTime<ctx_message, MPMCQueue>(mpmcQueue, nHeavyTestTime, 1, 1)) {
+                printf("check fail!\n");
+            }
+            printf("CCLockfreeQueue SPSC heavy\n");
+            if (!BenchmarkQueueTime<ctx_message, SPSCQueue>(spscQueue, nHeavyTestTime, 1, 1)) {
                 printf("check fail!\n");
             }
             printf("/*************************************************************************/\n");
         }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> MPMCQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueueMPSCFunc> MPSCQueue;
+            MPMCQueue mpmcQueue;
+            MPSCQueue mpscQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue multi producer one consumer\n");
+            printf("CCLockfreeQueue MPMC\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, MPMCQueue>(mpmcQueue, nRepeatTimes, nMinThread, nMaxThread, 1)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeQueue MPSC\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, MPSCQueue>(mpscQueue, nRepeatTimes, nMinThread, nMaxThread, 1)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeQueue MPSC bulk(%d)\n", BULK_SIZE);
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueueBulk<ctx_message, MPSCQueue>(mpscQueue, nRepeatTimes, nMinThread, nMaxThread, 1)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
         {
             cclockfree::CCLockfreeFixQueue<ctx_message, POW2SIZE>* pBasicQueue = new cclockfree::CCLockfreeFixQueue<ctx_message, POW2SIZE>();
             printf("/*************************************************************************/\n");
@@ -144,6 +694,247 @@ int main(int argc, char* argv[]){
             //printf("/*************************************************************************/\n");
             delete pBasicQueue;
         }
+        {
+            typedef cclockfree::CCLockfreeBroadcastFixQueue<ctx_message, 0, cclockfree::CCLockfreePaddingFunc> BroadcastFixQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, 0, cclockfree::CCLockfreeSequenceFunc> ConsumerFixQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeBroadcastFixQueue push thread(1)\n");
+            for (int nThreadCount = nMinThread; nThreadCount <= nMaxThread; nThreadCount *= 2) {
+                if (!BenchmarkBroadcastQueue<ctx_message, BroadcastFixQueue, ConsumerFixQueue>(nThreadCount, 65536, TIMES_FAST)) {
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> MallocQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueueNumaFunc<0>> NumaQueue;
+            typedef cclockfree::CCLockfreeNumaQueue<ctx_message> NodeLocalQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue numa node(%d) producer pin every node\n", cclockfree::CCLockfreeNumaNodeCount());
+            for (int nThreadCount = nMinThread; nThreadCount <= nMaxThread; nThreadCount *= 2) {
+                printf("CCLockfreeQueue malloc\n");
+                if (!BenchmarkNumaQueue<ctx_message, MallocQueue>(0, nThreadCount, TIMES_FAST / nThreadCount)) {
+                    break;
+                }
+                printf("CCLockfreeQueue bind node(0)\n");
+                if (!BenchmarkNumaQueue<ctx_message, NumaQueue>(0, nThreadCount, TIMES_FAST / nThreadCount)) {
+                    break;
+                }
+                printf("CCLockfreeNumaQueue queue every node\n");
+                if (!BenchmarkNumaQueue<ctx_message, NodeLocalQueue>(0, nThreadCount, TIMES_FAST / nThreadCount)) {
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, 0, cclockfree::CCLockfreeOverwriteFunc> OverwriteFixQueue;
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeFixQueue overwrite oldest size(4096)\n");
+            for (int nThreadCount = nMinThread; nThreadCount <= nMaxThread; nThreadCount *= 2) {
+                OverwriteFixQueue overwriteQueue(4096);
+                if (!BenchmarkOverwriteQueue<ctx_message, OverwriteFixQueue>(overwriteQueue, nThreadCount, TIMES_FAST / nThreadCount)) {
+                    break;
+                }
+            }
+            printf("Start CCLockfreeFixQueue overwrite oldest size(%d) never full\n", POW2SIZE);
+            for (int nThreadCount = nMinThread; nThreadCount <= nMaxThread; nThreadCount *= 2) {
+                OverwriteFixQueue overwriteQueue(POW2SIZE);
+                if (!BenchmarkOverwriteQueue<ctx_message, OverwriteFixQueue>(overwriteQueue, nThreadCount, TIMES_FAST / nThreadCount)) {
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, 0> RuntimeFixQueue;
+            RuntimeFixQueue runtimeQueue(POW2SIZE);
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeFixQueue runtime size(%d)\n", runtimeQueue.GetCapacity());
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, RuntimeFixQueue>(runtimeQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
+        {
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, POW2SIZE> CounterFixQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, POW2SIZE, cclockfree::CCLockfreeSequenceFunc> SequenceFixQueue;
+            CounterFixQueue* pCounterFixQueue = new CounterFixQueue();
+            SequenceFixQueue* pSequenceFixQueue = new SequenceFixQueue();
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeFixQueue counter/sequence thread(1-16)\n");
+            printf("CCLockfreeFixQueue counter\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, CounterFixQueue>(*pCounterFixQueue, nRepeatTimes, 1, 16)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeFixQueue sequence\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, SequenceFixQueue>(*pSequenceFixQueue, nRepeatTimes, 1, 16)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+            delete pCounterFixQueue;
+            delete pSequenceFixQueue;
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message> PackQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message, cclockfree::CCLockfreeQueuePaddingFunc> PaddingQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, POW2SIZE> PackFixQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message, POW2SIZE, cclockfree::CCLockfreePaddingFunc> PaddingFixQueue;
+            PackQueue packQueue;
+            PaddingQueue paddingQueue;
+            PackFixQueue* pPackFixQueue = new PackFixQueue();
+            PaddingFixQueue* pPaddingFixQueue = new PaddingFixQueue();
+            printf("/*************************************************************************/\n");
+            printf("Start layout pack/padding thread(4-16)\n");
+            printf("CCLockfreeQueue pack\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, PackQueue>(packQueue, nRepeatTimes, 4, 16)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeQueue padding\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, PaddingQueue>(paddingQueue, nRepeatTimes, 4, 16)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeFixQueue pack\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, PackFixQueue>(*pPackFixQueue, nRepeatTimes, 4, 16)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeFixQueue padding\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message, PaddingFixQueue>(*pPaddingFixQueue, nRepeatTimes, 4, 16)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+            delete pPackFixQueue;
+            delete pPaddingFixQueue;
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message*> FlagPointerQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message*, cclockfree::CCLockfreeQueuePointerFunc> PointerQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message*, POW2SIZE> FlagPointerFixQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message*, POW2SIZE, cclockfree::CCLockfreePointerFunc> PointerFixQueue;
+            FlagPointerQueue flagPointerQueue;
+            PointerQueue pointerQueue;
+            FlagPointerFixQueue* pFlagPointerFixQueue = new FlagPointerFixQueue();
+            PointerFixQueue* pPointerFixQueue = new PointerFixQueue();
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue pointer flag slot\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueuePointer<ctx_message, FlagPointerQueue>(flagPointerQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("Start CCLockfreeQueue pointer slot\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueuePointer<ctx_message, PointerQueue>(pointerQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeFixQueue pointer flag slot\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueuePointer<ctx_message, FlagPointerFixQueue>(*pFlagPointerFixQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("Start CCLockfreeFixQueue pointer slot\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueuePointer<ctx_message, PointerFixQueue>(*pPointerFixQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+            delete pFlagPointerFixQueue;
+            delete pPointerFixQueue;
+        }
+        {
+            typedef cclockfree::CCLockfreeQueue<ctx_message_small, cclockfree::CCLockfreeQueuePackFunc> PackQueue;
+            typedef cclockfree::CCLockfreeQueue<ctx_message_small> FlagQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message_small, POW2SIZE, cclockfree::CCLockfreePackFunc> PackFixQueue;
+            typedef cclockfree::CCLockfreeFixQueue<ctx_message_small, POW2SIZE> FlagFixQueue;
+            PackQueue packQueue;
+            FlagQueue flagQueue;
+            PackFixQueue* pPackFixQueue = new PackFixQueue();
+            FlagFixQueue* pFlagFixQueue = new FlagFixQueue();
+            printf("/*************************************************************************/\n");
+            printf("Start small payload(%d) packed/flag slot\n", (int)sizeof(ctx_message_small));
+            printf("CCLockfreeQueue packed\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message_small, PackQueue>(packQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeQueue flag\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message_small, FlagQueue>(flagQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeFixQueue packed\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message_small, PackFixQueue>(*pPackFixQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("CCLockfreeFixQueue flag\n");
+            for (int i = 0; i < nTimes; i++) {
+                if (!BenchmarkQueue<ctx_message_small, FlagFixQueue>(*pFlagFixQueue, nRepeatTimes, nMinThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+            delete pPackFixQueue;
+            delete pFlagFixQueue;
+        }
+        {
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeFixQueue slot layout array/split\n");
+            BenchmarkFixQueueLayout<ctx_message>(nRepeatTimes, nMinThread, nMaxThread);
+            BenchmarkFixQueueLayout<ctx_message_payload<32>>(nRepeatTimes, nMinThread, nMaxThread);
+            BenchmarkFixQueueLayout<ctx_message_payload<64>>(nRepeatTimes, nMinThread, nMaxThread);
+            printf("/*************************************************************************/\n");
+        }
+        {
+            printf("/*************************************************************************/\n");
+            printf("Start CCLockfreeQueue lane count thread(%d)\n", nMaxThread);
+            for (uint32_t nLaneCount = 1; nLaneCount <= 64; nLaneCount *= 2) {
+                cclockfree::CCLockfreeQueue<ctx_message> laneQueue(nLaneCount);
+                printf("LaneCount(%d)\n", nLaneCount);
+                if (!BenchmarkQueue<ctx_message, cclockfree::CCLockfreeQueue<ctx_message>>(laneQueue, nRepeatTimes, nMaxThread, nMaxThread)) {
+                    printf("check fail!\n");
+                    break;
+                }
+            }
+            printf("/*************************************************************************/\n");
+        }
     }
     
 	getchar();